@@ -3,6 +3,9 @@
 #ifndef BINARY_SEARCH_TREE_H
 #define BINARY_SEARCH_TREE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 
 /* basic data structures */
 
@@ -24,6 +27,72 @@ struct bst_node * bst_delete(struct bst_node *root, struct bst_node *node,
 void bst_free(struct bst_node *root, int free_keys, int free_data);
 
 
+/* red-black trees, balanced variants of bst_insert and bst_delete which
+   guarantee O(log n) height, all other functions (including bst_free) work
+   on red-black trees unchanged but the two variants must not be mixed on the
+   same tree, rbt_delete frees exactly node and leaves all other nodes valid */
+
+struct bst_node * rbt_insert(struct bst_node *root, void *key, void *data,
+                             int(*comp)(void const *, void const *));
+
+struct bst_node * rbt_delete(struct bst_node *root, struct bst_node *node,
+                             int free_key, int free_data);
+
+
+/* node pools, the _pool_ variants of the functions above allocate nodes from
+   pool instead of with malloc, a pool should back exactly one tree and the
+   nodes of that tree must only be inserted and deleted via pool functions,
+   bst_pool_free releases pool together with all nodes allocated from it in
+   time independent of the number of nodes unless keys or data are freed */
+
+struct bst_pool;
+
+struct bst_pool * bst_pool_create(void);
+
+void bst_pool_free(struct bst_pool *pool, struct bst_node *root,
+                   int free_keys, int free_data);
+
+struct bst_node * bst_pool_insert(struct bst_pool *pool,
+                                  struct bst_node *root, void *key, void *data,
+                                  int(*comp)(void const *, void const *));
+
+struct bst_node * bst_pool_delete(struct bst_pool *pool,
+                                  struct bst_node *root, struct bst_node *node,
+                                  int free_key, int free_data);
+
+struct bst_node * rbt_pool_insert(struct bst_pool *pool,
+                                  struct bst_node *root, void *key, void *data,
+                                  int(*comp)(void const *, void const *));
+
+struct bst_node * rbt_pool_delete(struct bst_pool *pool,
+                                  struct bst_node *root, struct bst_node *node,
+                                  int free_key, int free_data);
+
+/* bulk loading, bst_pool_build builds a balanced tree from n keys that are
+   already sorted with a single allocation from pool, rbt_pool_insert_batch
+   inserts n keys in any order into a tree (pool may be NULL), rebuilding it
+   in linear time if the batch is not small compared to the tree, data may be
+   NULL in both cases, the results are valid red-black trees, NULL is
+   returned if out of memory in which case the tree has not been modified */
+
+struct bst_node * bst_pool_build(struct bst_pool *pool,
+                                 void **keys, void **data, size_t n);
+
+struct bst_node * rbt_pool_insert_batch(
+    struct bst_pool *pool, struct bst_node *root,
+    void **keys, void **data, size_t n,
+    int(*comp)(void const *, void const *));
+
+/* insert a new node as the left (if left is nonzero) or right child of
+   parent, which the caller has found by searching for key, or as the root if
+   parent is NULL, this allows callers to search with their own comparison,
+   pool may be NULL */
+struct bst_node * rbt_pool_insert_at(struct bst_pool *pool,
+                                     struct bst_node *root,
+                                     struct bst_node *parent, int left,
+                                     void *key, void *data);
+
+
 /* searching */
 
 struct bst_node * bst_search(struct bst_node *root, void const *key,
@@ -45,4 +114,112 @@ void bst_iter_free(struct bst_iter *it);
 int bst_iter_has_next(struct bst_iter const *it);
 struct bst_node * bst_iter_next(struct bst_iter *it);
 
+
+/* compact red-black trees with 64 bit integer keys, all nodes are stored in
+   one array and refer to each other by 32 bit indices, a node's index stays
+   valid until it is deleted but pointers returned by bst_compact_get are
+   invalidated by the next insertion, equal keys are allowed */
+
+#define BST_COMPACT_NIL 0u
+
+struct bst_compact_node {
+    int64_t key;
+    void *data;
+    uint32_t left, right, parent;
+    uint32_t red;
+};
+
+struct bst_compact;
+
+struct bst_compact * bst_compact_create(size_t capacity);
+void bst_compact_free(struct bst_compact *t, int free_data);
+
+size_t bst_compact_size(struct bst_compact const *t);
+struct bst_compact_node * bst_compact_get(struct bst_compact *t,
+                                          uint32_t node);
+
+/* return the new node's index or BST_COMPACT_NIL if out of memory */
+uint32_t bst_compact_insert(struct bst_compact *t, int64_t key, void *data);
+void bst_compact_delete(struct bst_compact *t, uint32_t node, int free_data);
+
+uint32_t bst_compact_search(struct bst_compact const *t, int64_t key);
+
+uint32_t bst_compact_min(struct bst_compact const *t);
+uint32_t bst_compact_max(struct bst_compact const *t);
+uint32_t bst_compact_min_subtree(struct bst_compact const *t, uint32_t node);
+uint32_t bst_compact_max_subtree(struct bst_compact const *t, uint32_t node);
+uint32_t bst_compact_predecessor(struct bst_compact const *t, uint32_t node);
+uint32_t bst_compact_successor(struct bst_compact const *t, uint32_t node);
+
+
+/* frozen snapshots, immutable copies of a tree laid out for fast searching,
+   keys are 64 bit integers which bst_freeze obtains by applying key_value to
+   the tree's keys (this must preserve their order), elements are referred to
+   by positions which are BST_FROZEN_NONE for missing elements, the lower
+   bound is the first element whose key is not less than key */
+
+#define BST_FROZEN_NONE 0u
+
+struct bst_frozen;
+
+struct bst_frozen * bst_freeze(struct bst_node *root,
+                               int64_t(*key_value)(void const *key));
+struct bst_frozen * bst_compact_freeze(struct bst_compact *t);
+void bst_frozen_free(struct bst_frozen *f);
+
+size_t bst_frozen_size(struct bst_frozen const *f);
+
+size_t bst_frozen_search(struct bst_frozen const *f, int64_t key);
+size_t bst_frozen_lower_bound(struct bst_frozen const *f, int64_t key);
+
+int64_t bst_frozen_key(struct bst_frozen const *f, size_t pos);
+void * bst_frozen_data(struct bst_frozen const *f, size_t pos);
+
+size_t bst_frozen_min(struct bst_frozen const *f);
+size_t bst_frozen_successor(struct bst_frozen const *f, size_t pos);
+
+
+/* concurrent red-black trees with unique keys, writers may insert and delete
+   from any thread and are serialized internally while readers search without
+   taking locks (only creating and freeing readers does), readers retry
+   instead while a writer modifies the tree, every reader thread needs its own
+   struct bst_reader, deleted nodes and their keys and data are only freed
+   once no reader can reference them anymore, by a later write or by the last
+   reader leaving, key and data pointers returned to a reader remain valid
+   until it leaves its outermost read-side critical section (bst_reader_lock
+   and bst_reader_unlock may be nested, searching enters one implicitly) */
+
+struct bst_concurrent;
+struct bst_reader;
+
+struct bst_concurrent * bst_concurrent_create(
+    int(*comp)(void const *, void const *));
+
+/* all readers are freed as well, no thread may access t anymore */
+void bst_concurrent_free(struct bst_concurrent *t, int free_keys,
+                         int free_data);
+
+/* return 1 if key has been inserted, 0 if it is already present and -1 if
+   out of memory */
+int bst_concurrent_insert(struct bst_concurrent *t, void *key, void *data);
+
+/* return 1 if key has been deleted and 0 if it is not present */
+int bst_concurrent_delete(struct bst_concurrent *t, void const *key,
+                          int free_key, int free_data);
+
+struct bst_reader * bst_reader_create(struct bst_concurrent *t);
+void bst_reader_free(struct bst_reader *r);
+
+void bst_reader_lock(struct bst_reader *r);
+void bst_reader_unlock(struct bst_reader *r);
+
+/* return 1 and store data if key is present */
+int bst_reader_search(struct bst_reader *r, void const *key, void **data);
+
+/* return 1 and store the smallest key greater than key (or the smallest key
+   if key is NULL) and its data if there is one, next_key and data may be
+   NULL */
+int bst_reader_next(struct bst_reader *r, void const *key,
+                    void **next_key, void **data);
+
 #endif
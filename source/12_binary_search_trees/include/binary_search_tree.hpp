@@ -0,0 +1,291 @@
+#ifndef BINARY_SEARCH_TREE_HPP
+#define BINARY_SEARCH_TREE_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+extern "C" {
+#include "binary_search_tree.h"
+}
+
+/* Red-black tree over struct bst_node whose key comparison is known at
+   compile time, searching and the descent of insertions are performed here so
+   that Compare can be inlined, rebalancing, deletion and node allocation are
+   left to the C functions. Arithmetic keys and values that fit into a pointer
+   are stored in the node's key and data pointers themselves, all other keys
+   and values are allocated individually. */
+
+namespace bst_detail {
+
+template<typename T, bool Inline = std::is_arithmetic<T>::value &&
+                                   sizeof(T) <= sizeof(void *)>
+struct storage;
+
+template<typename T>
+struct storage<T, true>
+{
+    typedef T ref;
+    typedef T const_ref;
+
+    static constexpr bool is_inline = true;
+
+    static void *create(T const &val) {
+        void *ptr = nullptr;
+        std::memcpy(&ptr, &val, sizeof(T));
+        return ptr;
+    }
+
+    static void destroy(void *) {}
+
+    static T get(void *const &ptr) {
+        T val;
+        std::memcpy(&val, &ptr, sizeof(T));
+        return val;
+    }
+};
+
+template<typename T>
+struct storage<T, false>
+{
+    typedef T &ref;
+    typedef T const &const_ref;
+
+    static constexpr bool is_inline = false;
+
+    static void *create(T const &val) {
+        return new T(val);
+    }
+
+    static void destroy(void *ptr) {
+        delete static_cast<T *>(ptr);
+    }
+
+    static T &get(void *const &ptr) {
+        return *static_cast<T *>(ptr);
+    }
+};
+
+} // namespace bst_detail
+
+template<typename Key, typename Value, typename Compare = std::less<Key>>
+class bst
+{
+    typedef bst_detail::storage<Key> key_storage;
+    typedef bst_detail::storage<Value> value_storage;
+
+public:
+    class iterator
+    {
+        friend class bst;
+
+    public:
+        typename key_storage::const_ref key() const {
+            return key_storage::get(node_->key);
+        }
+
+        typename value_storage::ref value() const {
+            return value_storage::get(node_->data);
+        }
+
+        iterator &operator++() {
+            node_ = bst_successor(node_);
+            return *this;
+        }
+
+        bool operator==(iterator const &other) const {
+            return node_ == other.node_;
+        }
+
+        bool operator!=(iterator const &other) const {
+            return node_ != other.node_;
+        }
+
+        struct bst_node *node() const {
+            return node_;
+        }
+
+    private:
+        explicit iterator(struct bst_node *node)
+        : node_(node)
+        {}
+
+        struct bst_node *node_;
+    };
+
+    /* the node pool is only created by the first insertion, so empty trees,
+       including moved from and cleared ones, own no memory */
+    explicit bst(Compare const &comp = Compare())
+    : comp_(comp),
+      pool_(nullptr),
+      root_(nullptr),
+      size_(0u)
+    {}
+
+    bst(bst const &) = delete;
+    bst &operator=(bst const &) = delete;
+
+    bst(bst &&other)
+        noexcept(std::is_nothrow_move_constructible<Compare>::value)
+    : comp_(std::move(other.comp_)),
+      pool_(other.pool_),
+      root_(other.root_),
+      size_(other.size_)
+    {
+        other.pool_ = nullptr;
+        other.root_ = nullptr;
+        other.size_ = 0u;
+    }
+
+    bst &operator=(bst &&other)
+        noexcept(std::is_nothrow_move_assignable<Compare>::value)
+    {
+        if (this != &other) {
+            destroy();
+
+            comp_ = std::move(other.comp_);
+            pool_ = other.pool_;
+            root_ = other.root_;
+            size_ = other.size_;
+
+            other.pool_ = nullptr;
+            other.root_ = nullptr;
+            other.size_ = 0u;
+        }
+
+        return *this;
+    }
+
+    ~bst() {
+        destroy();
+    }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0u; }
+
+    /* the underlying tree, must not be modified */
+    struct bst_node *root() const { return root_; }
+
+    iterator begin() const { return iterator(bst_min(root_)); }
+    iterator end() const { return iterator(nullptr); }
+
+    /* equal keys are allowed, as with bst_insert they are inserted after
+       all present equal keys */
+    void insert(Key const &key, Value const &value) {
+        struct bst_node *parent = nullptr;
+        struct bst_node *current = root_;
+
+        bool less = false;
+
+        while (current) {
+            parent = current;
+            less = comp_(key, key_storage::get(current->key));
+
+            current = less ? current->left : current->right;
+        }
+
+        if (!pool_) {
+            pool_ = bst_pool_create();
+            if (!pool_)
+                throw std::bad_alloc();
+        }
+
+        void *key_ptr = key_storage::create(key);
+        void *value_ptr;
+
+        try {
+            value_ptr = value_storage::create(value);
+        } catch (...) {
+            key_storage::destroy(key_ptr);
+            throw;
+        }
+
+        struct bst_node *root = rbt_pool_insert_at(pool_, root_, parent, less,
+                                                   key_ptr, value_ptr);
+        if (!root) {
+            key_storage::destroy(key_ptr);
+            value_storage::destroy(value_ptr);
+            throw std::bad_alloc();
+        }
+
+        root_ = root;
+        ++size_;
+    }
+
+    iterator find(Key const &key) const {
+        struct bst_node *node = root_;
+
+        while (node) {
+            typename key_storage::const_ref node_key =
+                key_storage::get(node->key);
+
+            if (comp_(key, node_key))
+                node = node->left;
+            else if (comp_(node_key, key))
+                node = node->right;
+            else
+                break;
+        }
+
+        return iterator(node);
+    }
+
+    bool contains(Key const &key) const {
+        return find(key) != end();
+    }
+
+    void erase(iterator it) {
+        struct bst_node *node = it.node_;
+
+        key_storage::destroy(node->key);
+        value_storage::destroy(node->data);
+
+        root_ = rbt_pool_delete(pool_, root_, node, 0, 0);
+        --size_;
+    }
+
+    bool erase(Key const &key) {
+        iterator it = find(key);
+        if (it == end())
+            return false;
+
+        erase(it);
+
+        return true;
+    }
+
+    void clear() {
+        destroy();
+    }
+
+private:
+    void destroy() {
+        if (!key_storage::is_inline || !value_storage::is_inline) {
+            for (struct bst_node *node = bst_min(root_);
+                 node;
+                 node = bst_successor(node)) {
+
+                key_storage::destroy(node->key);
+                value_storage::destroy(node->data);
+            }
+        }
+
+        /* pooled nodes are released all at once */
+        bst_pool_free(pool_, nullptr, 0, 0);
+
+        pool_ = nullptr;
+        root_ = nullptr;
+        size_ = 0u;
+    }
+
+    Compare comp_;
+
+    struct bst_pool *pool_;
+    struct bst_node *root_;
+    std::size_t size_;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 
 #include "binary_search_tree.h"
+#include "binary_search_tree_impl.h"
 
 
 /* insertion and deletion */
@@ -8,7 +9,14 @@
 struct bst_node * bst_insert(struct bst_node *root, void *key, void *data,
                              int(*comp)(void const *, void const *))
 {
-    struct bst_node *tmp = malloc(sizeof(struct bst_node));
+    return bst_pool_insert(NULL, root, key, data, comp);
+}
+
+struct bst_node * bst_pool_insert(struct bst_pool *pool,
+                                  struct bst_node *root, void *key, void *data,
+                                  int(*comp)(void const *, void const *))
+{
+    struct bst_node *tmp = bst_node_alloc(pool, sizeof(struct bst_node));
     if (!tmp)
         return NULL;
 
@@ -45,6 +53,13 @@ struct bst_node * bst_insert(struct bst_node *root, void *key, void *data,
 
 struct bst_node * bst_delete(struct bst_node *root, struct bst_node *node,
                              int free_key, int free_data)
+{
+    return bst_pool_delete(NULL, root, node, free_key, free_data);
+}
+
+struct bst_node * bst_pool_delete(struct bst_pool *pool,
+                                  struct bst_node *root, struct bst_node *node,
+                                  int free_key, int free_data)
 {
     if (!root || !node)
         return NULL;
@@ -81,26 +96,48 @@ struct bst_node * bst_delete(struct bst_node *root, struct bst_node *node,
         node->data = tmp1->data;
     }
 
-    free(tmp1);
+    bst_node_release(pool, tmp1);
 
     return root;
 }
 
 void bst_free(struct bst_node *root, int free_keys, int free_data)
 {
-    if (!root)
-        return;
+    /* postorder traversal along parent pointers, trees can be deep */
+    struct bst_node *node = root;
 
-    bst_free(root->left, free_keys, free_data);
-    bst_free(root->right, free_keys, free_data);
+    while (node) {
+        if (node->left) {
+            node = node->left;
+            continue;
+        }
 
-    if (free_keys)
-        free(root->key);
+        if (node->right) {
+            node = node->right;
+            continue;
+        }
 
-    if (free_data)
-        free(root->data);
+        struct bst_node *parent = NULL;
+
+        if (node != root) {
+            parent = node->parent;
+
+            if (node == parent->left)
+                parent->left = NULL;
+            else
+                parent->right = NULL;
+        }
 
-    free(root);
+        if (free_keys)
+            free(node->key);
+
+        if (free_data)
+            free(node->data);
+
+        free(node);
+
+        node = parent;
+    }
 }
 
 
@@ -0,0 +1,34 @@
+#ifndef BINARY_SEARCH_TREE_IMPL_H
+#define BINARY_SEARCH_TREE_IMPL_H
+
+#include <stddef.h>
+
+#include "binary_search_tree.h"
+
+
+/* red-black tree nodes, the plain node comes first so that a red-black tree
+   can be treated as a plain tree */
+
+struct rbt_node {
+    struct bst_node node;
+    int red;
+};
+
+/* link node, whose key and data have been set, into a red-black tree like
+   rbt_pool_insert_at */
+struct bst_node * rbt_link(struct bst_node *root, struct bst_node *parent,
+                           int left, struct bst_node *node);
+
+
+/* node allocation, nodes are allocated with malloc and released with free if
+   pool is NULL, pooled nodes are large enough to hold a struct rbt_node */
+
+struct bst_node * bst_node_alloc(struct bst_pool *pool, size_t size);
+void bst_node_release(struct bst_pool *pool, struct bst_node *node);
+
+/* allocate n consecutive nodes from pool with a single allocation, the i-th
+   node starts stride * i bytes after the first */
+struct bst_node * bst_node_alloc_array(struct bst_pool *pool, size_t n,
+                                       size_t *stride);
+
+#endif
@@ -0,0 +1,286 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "binary_search_tree.h"
+#include "binary_search_tree_impl.h"
+
+/* Trees are built from a sorted sequence of nodes by recursively making the
+   middle node the root of its range, subtree sizes then differ by at most one
+   at every node, so all nodes are at most floor(log2(n)) levels deep while
+   all levels above the deepest one are full. Coloring the deepest level red
+   and all other nodes black thus yields a valid red-black tree. */
+
+
+/* node sequences */
+
+struct node_seq {
+    struct bst_node **nodes; /* either an array of node pointers */
+    char *base;              /* or nodes stored stride bytes apart */
+    size_t stride;
+};
+
+static struct bst_node * seq_at(struct node_seq const *seq, size_t i)
+{
+    if (seq->nodes)
+        return seq->nodes[i];
+
+    return (struct bst_node *) (seq->base + i * seq->stride);
+}
+
+static size_t floor_log2(size_t n)
+{
+    size_t log = 0u;
+    while (n >>= 1u)
+        ++log;
+
+    return log;
+}
+
+static struct bst_node * link_balanced(struct node_seq const *seq,
+                                       size_t lo, size_t hi,
+                                       struct bst_node *parent,
+                                       size_t depth, size_t red_depth)
+{
+    if (lo == hi)
+        return NULL;
+
+    size_t mid = lo + (hi - lo) / 2u;
+
+    struct bst_node *node = seq_at(seq, mid);
+
+    node->parent = parent;
+    node->left = link_balanced(seq, lo, mid, node, depth + 1u, red_depth);
+    node->right = link_balanced(seq, mid + 1u, hi, node, depth + 1u,
+                                red_depth);
+
+    ((struct rbt_node *) node)->red = depth == red_depth;
+
+    return node;
+}
+
+static struct bst_node * link_all(struct node_seq const *seq, size_t n)
+{
+    /* a single node is the root and must stay black */
+    size_t red_depth = n > 1u ? floor_log2(n) : SIZE_MAX;
+
+    return link_balanced(seq, 0u, n, NULL, 0u, red_depth);
+}
+
+
+/* bulk loading */
+
+struct bst_node * bst_pool_build(struct bst_pool *pool,
+                                 void **keys, void **data, size_t n)
+{
+    if (!pool || n == 0u)
+        return NULL;
+
+    size_t stride;
+    struct bst_node *nodes = bst_node_alloc_array(pool, n, &stride);
+    if (!nodes)
+        return NULL;
+
+    struct node_seq seq = {
+        .nodes = NULL, .base = (char *) nodes, .stride = stride
+    };
+
+    for (size_t i = 0u; i < n; ++i) {
+        struct bst_node *node = seq_at(&seq, i);
+
+        node->key = keys[i];
+        node->data = data ? data[i] : NULL;
+    }
+
+    return link_all(&seq, n);
+}
+
+
+/* batch insertion */
+
+static void sort_batch(size_t *idx, size_t *tmp, size_t n, void **keys,
+                       int(*comp)(void const *, void const *))
+{
+    /* stable merge sort so that equal keys keep their batch order */
+    if (n < 2u)
+        return;
+
+    size_t half = n / 2u;
+
+    sort_batch(idx, tmp, half, keys, comp);
+    sort_batch(idx + half, tmp, n - half, keys, comp);
+
+    size_t i = 0u, j = half, k = 0u;
+
+    while (i < half && j < n) {
+        if (comp(keys[idx[j]], keys[idx[i]]) < 0)
+            tmp[k++] = idx[j++];
+        else
+            tmp[k++] = idx[i++];
+    }
+
+    while (i < half)
+        tmp[k++] = idx[i++];
+
+    while (j < n)
+        tmp[k++] = idx[j++];
+
+    for (k = 0u; k < n; ++k)
+        idx[k] = tmp[k];
+}
+
+static int alloc_batch(struct bst_pool *pool, struct bst_node **fresh,
+                       size_t n)
+{
+    if (pool) {
+        size_t stride;
+        struct bst_node *nodes = bst_node_alloc_array(pool, n, &stride);
+        if (!nodes)
+            return 0;
+
+        for (size_t i = 0u; i < n; ++i)
+            fresh[i] = (struct bst_node *) ((char *) nodes + i * stride);
+
+        return 1;
+    }
+
+    for (size_t i = 0u; i < n; ++i) {
+        fresh[i] = bst_node_alloc(NULL, sizeof(struct rbt_node));
+
+        if (!fresh[i]) {
+            while (i--)
+                bst_node_release(NULL, fresh[i]);
+
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static struct bst_node * insert_each(struct bst_node *root,
+                                     struct bst_node **fresh, size_t n,
+                                     int(*comp)(void const *, void const *))
+{
+    for (size_t i = 0u; i < n; ++i) {
+        struct bst_node *current, *parent;
+        parent = NULL;
+        current = root;
+
+        int less = 0;
+
+        while (current) {
+            parent = current;
+            less = comp(fresh[i]->key, current->key) < 0;
+
+            if (less)
+                current = current->left;
+            else
+                current = current->right;
+        }
+
+        root = rbt_link(root, parent, less, fresh[i]);
+    }
+
+    return root;
+}
+
+/* all has room for size + n nodes */
+static struct bst_node * merge_rebuild(struct bst_node *root,
+                                       struct bst_node **fresh, size_t n,
+                                       struct bst_node **all, size_t size,
+                                       int(*comp)(void const *, void const *))
+{
+    size_t j = n;
+    for (struct bst_node *node = bst_min(root);
+         node;
+         node = bst_successor(node)) {
+
+        all[j++] = node;
+    }
+
+    /* merge the existing nodes stored behind the batch in place, present
+       keys come before equal batch keys */
+    size_t i = 0u, k = 0u;
+    j = n;
+
+    while (i < n && j < size + n) {
+        if (comp(fresh[i]->key, all[j]->key) < 0)
+            all[k++] = fresh[i++];
+        else
+            all[k++] = all[j++];
+    }
+
+    while (i < n)
+        all[k++] = fresh[i++];
+
+    struct node_seq seq = { .nodes = all, .base = NULL, .stride = 0u };
+
+    return link_all(&seq, size + n);
+}
+
+struct bst_node * rbt_pool_insert_batch(
+    struct bst_pool *pool, struct bst_node *root,
+    void **keys, void **data, size_t n,
+    int(*comp)(void const *, void const *))
+{
+    if (n == 0u)
+        return root;
+
+    if (n > SIZE_MAX / (2u * sizeof(size_t)))
+        return NULL;
+
+    /* rebuilding costs O(size + n) and inserting one by one O(n log(size)),
+       rebuilding can only pay off if size <= n * (floor(log2(size)) + 1), so
+       counting stops after n times the number of bits in a size_t nodes and
+       the cost of inserting a small batch stays independent of size */
+    size_t bits = sizeof(size_t) * 8u;
+    size_t max_size = n <= SIZE_MAX / bits ? n * bits : SIZE_MAX;
+
+    size_t size = 0u;
+    for (struct bst_node *node = bst_min(root);
+         node && size <= max_size;
+         node = bst_successor(node)) {
+
+        ++size;
+    }
+
+    int rebuild = size <= max_size && size / (floor_log2(size) + 1u) <= n;
+
+    if (rebuild && size > SIZE_MAX / sizeof(struct bst_node *) - n)
+        return NULL;
+
+    size_t *idx = malloc(2u * n * sizeof(size_t));
+    struct bst_node **fresh = malloc(n * sizeof(struct bst_node *));
+    struct bst_node **all = NULL;
+
+    if (rebuild)
+        all = malloc((size + n) * sizeof(struct bst_node *));
+
+    if (!idx || !fresh || (rebuild && !all) || !alloc_batch(pool, fresh, n)) {
+        free(idx);
+        free(fresh);
+        free(all);
+        return NULL;
+    }
+
+    for (size_t i = 0u; i < n; ++i)
+        idx[i] = i;
+
+    sort_batch(idx, idx + n, n, keys, comp);
+
+    for (size_t i = 0u; i < n; ++i) {
+        fresh[i]->key = keys[idx[i]];
+        fresh[i]->data = data ? data[idx[i]] : NULL;
+    }
+
+    if (rebuild)
+        root = merge_rebuild(root, fresh, n, all, size, comp);
+    else
+        root = insert_each(root, fresh, n, comp);
+
+    free(idx);
+    free(fresh);
+    free(all);
+
+    return root;
+}
@@ -0,0 +1,510 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "binary_search_tree.h"
+
+/* All nodes live in one array which grows by doubling, nodes[0] is a black
+   sentinel standing in for all leaves and the root's parent as in CLRS, this
+   way deletion does not need to special-case missing children. Deleted nodes
+   are linked into a free list through their left index. */
+
+enum { MIN_CAPACITY = 16 };
+
+struct bst_compact {
+    struct bst_compact_node *nodes;
+    uint32_t capacity; /* including the sentinel */
+    uint32_t used;     /* array slots handed out including the sentinel */
+    uint32_t free_list;
+
+    uint32_t root;
+    size_t size;
+};
+
+
+/* creation and destruction */
+
+struct bst_compact * bst_compact_create(size_t capacity)
+{
+    if (capacity >= UINT32_MAX)
+        return NULL;
+
+    if (capacity < MIN_CAPACITY)
+        capacity = MIN_CAPACITY;
+    else
+        ++capacity;
+
+    struct bst_compact *t = malloc(sizeof(struct bst_compact));
+    if (!t)
+        return NULL;
+
+    t->nodes = malloc(capacity * sizeof(struct bst_compact_node));
+    if (!t->nodes) {
+        free(t);
+        return NULL;
+    }
+
+    t->nodes[BST_COMPACT_NIL] = (struct bst_compact_node) {
+        .key = 0, .data = NULL,
+        .left = BST_COMPACT_NIL, .right = BST_COMPACT_NIL,
+        .parent = BST_COMPACT_NIL, .red = 0u
+    };
+
+    t->capacity = (uint32_t) capacity;
+    t->used = 1u;
+    t->free_list = BST_COMPACT_NIL;
+
+    t->root = BST_COMPACT_NIL;
+    t->size = 0u;
+
+    return t;
+}
+
+void bst_compact_free(struct bst_compact *t, int free_data)
+{
+    if (!t)
+        return;
+
+    if (free_data) {
+        for (uint32_t node = bst_compact_min(t);
+             node != BST_COMPACT_NIL;
+             node = bst_compact_successor(t, node)) {
+
+            free(t->nodes[node].data);
+        }
+    }
+
+    free(t->nodes);
+    free(t);
+}
+
+size_t bst_compact_size(struct bst_compact const *t)
+{
+    return t->size;
+}
+
+struct bst_compact_node * bst_compact_get(struct bst_compact *t,
+                                          uint32_t node)
+{
+    return node == BST_COMPACT_NIL ? NULL : &t->nodes[node];
+}
+
+
+/* node allocation */
+
+static uint32_t node_alloc(struct bst_compact *t)
+{
+    uint32_t node = t->free_list;
+    if (node != BST_COMPACT_NIL) {
+        t->free_list = t->nodes[node].left;
+        return node;
+    }
+
+    if (t->used == t->capacity) {
+        if (t->capacity == UINT32_MAX)
+            return BST_COMPACT_NIL;
+
+        uint32_t capacity = t->capacity > UINT32_MAX / 2u ?
+                            UINT32_MAX : 2u * t->capacity;
+
+        struct bst_compact_node *nodes =
+            realloc(t->nodes, (size_t) capacity * sizeof(*nodes));
+
+        if (!nodes)
+            return BST_COMPACT_NIL;
+
+        t->nodes = nodes;
+        t->capacity = capacity;
+    }
+
+    return t->used++;
+}
+
+static void node_release(struct bst_compact *t, uint32_t node)
+{
+    t->nodes[node].left = t->free_list;
+    t->free_list = node;
+}
+
+
+/* rotations */
+
+static void rotate_left(struct bst_compact *t, uint32_t node)
+{
+    struct bst_compact_node *n = t->nodes;
+
+    uint32_t tmp = n[node].right;
+
+    n[node].right = n[tmp].left;
+    if (n[tmp].left != BST_COMPACT_NIL)
+        n[n[tmp].left].parent = node;
+
+    n[tmp].parent = n[node].parent;
+
+    if (n[node].parent == BST_COMPACT_NIL)
+        t->root = tmp;
+    else if (node == n[n[node].parent].left)
+        n[n[node].parent].left = tmp;
+    else
+        n[n[node].parent].right = tmp;
+
+    n[tmp].left = node;
+    n[node].parent = tmp;
+}
+
+static void rotate_right(struct bst_compact *t, uint32_t node)
+{
+    struct bst_compact_node *n = t->nodes;
+
+    uint32_t tmp = n[node].left;
+
+    n[node].left = n[tmp].right;
+    if (n[tmp].right != BST_COMPACT_NIL)
+        n[n[tmp].right].parent = node;
+
+    n[tmp].parent = n[node].parent;
+
+    if (n[node].parent == BST_COMPACT_NIL)
+        t->root = tmp;
+    else if (node == n[n[node].parent].right)
+        n[n[node].parent].right = tmp;
+    else
+        n[n[node].parent].left = tmp;
+
+    n[tmp].right = node;
+    n[node].parent = tmp;
+}
+
+
+/* insertion and deletion */
+
+static void insert_fixup(struct bst_compact *t, uint32_t node)
+{
+    struct bst_compact_node *n = t->nodes;
+
+    while (n[n[node].parent].red) {
+        uint32_t parent = n[node].parent;
+        uint32_t grandparent = n[parent].parent;
+
+        if (parent == n[grandparent].left) {
+            uint32_t uncle = n[grandparent].right;
+
+            if (n[uncle].red) {
+                n[parent].red = 0u;
+                n[uncle].red = 0u;
+                n[grandparent].red = 1u;
+                node = grandparent;
+                continue;
+            }
+
+            if (node == n[parent].right) {
+                rotate_left(t, parent);
+                node = parent;
+                parent = n[node].parent;
+            }
+
+            n[parent].red = 0u;
+            n[grandparent].red = 1u;
+            rotate_right(t, grandparent);
+
+        } else {
+            uint32_t uncle = n[grandparent].left;
+
+            if (n[uncle].red) {
+                n[parent].red = 0u;
+                n[uncle].red = 0u;
+                n[grandparent].red = 1u;
+                node = grandparent;
+                continue;
+            }
+
+            if (node == n[parent].left) {
+                rotate_right(t, parent);
+                node = parent;
+                parent = n[node].parent;
+            }
+
+            n[parent].red = 0u;
+            n[grandparent].red = 1u;
+            rotate_left(t, grandparent);
+        }
+    }
+
+    n[t->root].red = 0u;
+}
+
+uint32_t bst_compact_insert(struct bst_compact *t, int64_t key, void *data)
+{
+    uint32_t node = node_alloc(t);
+    if (node == BST_COMPACT_NIL)
+        return BST_COMPACT_NIL;
+
+    struct bst_compact_node *n = t->nodes;
+
+    uint32_t current, parent;
+    parent = BST_COMPACT_NIL;
+    current = t->root;
+
+    int less = 0;
+
+    while (current != BST_COMPACT_NIL) {
+        parent = current;
+        less = key < n[current].key;
+
+        if (less)
+            current = n[current].left;
+        else
+            current = n[current].right;
+    }
+
+    n[node] = (struct bst_compact_node) {
+        .key = key, .data = data,
+        .left = BST_COMPACT_NIL, .right = BST_COMPACT_NIL,
+        .parent = parent, .red = 1u
+    };
+
+    if (parent == BST_COMPACT_NIL)
+        t->root = node;
+    else if (less)
+        n[parent].left = node;
+    else
+        n[parent].right = node;
+
+    insert_fixup(t, node);
+
+    ++t->size;
+
+    return node;
+}
+
+static void transplant(struct bst_compact *t, uint32_t node,
+                       uint32_t replacement)
+{
+    struct bst_compact_node *n = t->nodes;
+
+    uint32_t parent = n[node].parent;
+
+    if (parent == BST_COMPACT_NIL)
+        t->root = replacement;
+    else if (node == n[parent].left)
+        n[parent].left = replacement;
+    else
+        n[parent].right = replacement;
+
+    /* may set the sentinel's parent which delete_fixup relies on */
+    n[replacement].parent = parent;
+}
+
+static void delete_fixup(struct bst_compact *t, uint32_t node)
+{
+    struct bst_compact_node *n = t->nodes;
+
+    while (node != t->root && !n[node].red) {
+        uint32_t parent = n[node].parent;
+
+        if (node == n[parent].left) {
+            uint32_t sibling = n[parent].right;
+
+            if (n[sibling].red) {
+                n[sibling].red = 0u;
+                n[parent].red = 1u;
+                rotate_left(t, parent);
+                sibling = n[parent].right;
+            }
+
+            if (!n[n[sibling].left].red && !n[n[sibling].right].red) {
+                n[sibling].red = 1u;
+                node = parent;
+                continue;
+            }
+
+            if (!n[n[sibling].right].red) {
+                n[n[sibling].left].red = 0u;
+                n[sibling].red = 1u;
+                rotate_right(t, sibling);
+                sibling = n[parent].right;
+            }
+
+            n[sibling].red = n[parent].red;
+            n[parent].red = 0u;
+            n[n[sibling].right].red = 0u;
+            rotate_left(t, parent);
+
+        } else {
+            uint32_t sibling = n[parent].left;
+
+            if (n[sibling].red) {
+                n[sibling].red = 0u;
+                n[parent].red = 1u;
+                rotate_right(t, parent);
+                sibling = n[parent].left;
+            }
+
+            if (!n[n[sibling].left].red && !n[n[sibling].right].red) {
+                n[sibling].red = 1u;
+                node = parent;
+                continue;
+            }
+
+            if (!n[n[sibling].left].red) {
+                n[n[sibling].right].red = 0u;
+                n[sibling].red = 1u;
+                rotate_left(t, sibling);
+                sibling = n[parent].left;
+            }
+
+            n[sibling].red = n[parent].red;
+            n[parent].red = 0u;
+            n[n[sibling].left].red = 0u;
+            rotate_right(t, parent);
+        }
+
+        node = t->root;
+    }
+
+    n[node].red = 0u;
+}
+
+void bst_compact_delete(struct bst_compact *t, uint32_t node, int free_data)
+{
+    if (node == BST_COMPACT_NIL)
+        return;
+
+    struct bst_compact_node *n = t->nodes;
+
+    uint32_t tmp;
+    int removed_red = n[node].red;
+
+    if (n[node].left == BST_COMPACT_NIL) {
+        tmp = n[node].right;
+        transplant(t, node, tmp);
+
+    } else if (n[node].right == BST_COMPACT_NIL) {
+        tmp = n[node].left;
+        transplant(t, node, tmp);
+
+    } else {
+        uint32_t succ = bst_compact_min_subtree(t, n[node].right);
+        removed_red = n[succ].red;
+
+        tmp = n[succ].right;
+
+        if (n[succ].parent == node) {
+            n[tmp].parent = succ;
+        } else {
+            transplant(t, succ, tmp);
+
+            n[succ].right = n[node].right;
+            n[n[succ].right].parent = succ;
+        }
+
+        transplant(t, node, succ);
+
+        n[succ].left = n[node].left;
+        n[n[succ].left].parent = succ;
+
+        n[succ].red = n[node].red;
+    }
+
+    if (free_data)
+        free(n[node].data);
+
+    node_release(t, node);
+
+    if (!removed_red)
+        delete_fixup(t, tmp);
+
+    --t->size;
+}
+
+
+/* searching */
+
+uint32_t bst_compact_search(struct bst_compact const *t, int64_t key)
+{
+    struct bst_compact_node const *n = t->nodes;
+
+    uint32_t node = t->root;
+
+    while (node != BST_COMPACT_NIL && n[node].key != key) {
+        if (key < n[node].key)
+            node = n[node].left;
+        else
+            node = n[node].right;
+    }
+
+    return node;
+}
+
+uint32_t bst_compact_min(struct bst_compact const *t)
+{
+    return bst_compact_min_subtree(t, t->root);
+}
+
+uint32_t bst_compact_max(struct bst_compact const *t)
+{
+    return bst_compact_max_subtree(t, t->root);
+}
+
+uint32_t bst_compact_min_subtree(struct bst_compact const *t, uint32_t node)
+{
+    struct bst_compact_node const *n = t->nodes;
+
+    if (node == BST_COMPACT_NIL)
+        return BST_COMPACT_NIL;
+
+    while (n[node].left != BST_COMPACT_NIL)
+        node = n[node].left;
+
+    return node;
+}
+
+uint32_t bst_compact_max_subtree(struct bst_compact const *t, uint32_t node)
+{
+    struct bst_compact_node const *n = t->nodes;
+
+    if (node == BST_COMPACT_NIL)
+        return BST_COMPACT_NIL;
+
+    while (n[node].right != BST_COMPACT_NIL)
+        node = n[node].right;
+
+    return node;
+}
+
+uint32_t bst_compact_predecessor(struct bst_compact const *t, uint32_t node)
+{
+    struct bst_compact_node const *n = t->nodes;
+
+    if (node == BST_COMPACT_NIL)
+        return BST_COMPACT_NIL;
+
+    if (n[node].left != BST_COMPACT_NIL)
+        return bst_compact_max_subtree(t, n[node].left);
+
+    uint32_t parent = n[node].parent;
+    while (parent != BST_COMPACT_NIL && node == n[parent].left) {
+        node = parent;
+        parent = n[parent].parent;
+    }
+
+    return parent;
+}
+
+uint32_t bst_compact_successor(struct bst_compact const *t, uint32_t node)
+{
+    struct bst_compact_node const *n = t->nodes;
+
+    if (node == BST_COMPACT_NIL)
+        return BST_COMPACT_NIL;
+
+    if (n[node].right != BST_COMPACT_NIL)
+        return bst_compact_min_subtree(t, n[node].right);
+
+    uint32_t parent = n[node].parent;
+    while (parent != BST_COMPACT_NIL && node == n[parent].right) {
+        node = parent;
+        parent = n[parent].parent;
+    }
+
+    return parent;
+}
@@ -0,0 +1,763 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "binary_search_tree.h"
+
+/* Writers are serialized by a mutex and rebalance the red-black tree in
+   place, bumping a sequence counter to an odd value for the duration of every
+   modification. Child pointers are published with release stores in an order
+   which never creates cycles, so readers can walk the tree without locking,
+   they only risk missing nodes which are being moved by a rotation. Readers
+   therefore validate results that depend on not having missed a node against
+   the sequence counter and retry if a writer has interfered, writer sections
+   are short so readers simply wait for the counter to become even again,
+   yielding the processor after a few unsuccessful attempts.
+
+   Removed nodes are reclaimed with epoch based reclamation: readers announce
+   the global epoch while inside a read-side critical section, the epoch is
+   only advanced once all active readers have announced the current one, so a
+   node removed during epoch e can no longer be referenced by any reader once
+   the epoch has reached e + 2. Reclamation is attempted by every write and
+   by readers leaving their outermost critical section, readers only do so if
+   the writer lock is free. */
+
+enum {
+    SPIN_READS = 8,
+    MAX_DEPTH = 2 * 64
+};
+
+struct concurrent_node {
+    struct concurrent_node *left, *right; /* accessed atomically */
+    struct concurrent_node *parent;
+    void *key;
+    void *data;
+    int red;
+
+    /* reclamation */
+    struct concurrent_node *next_retired;
+    size_t retire_epoch;
+    int free_key, free_data;
+};
+
+struct bst_reader {
+    struct bst_concurrent *t;
+    struct bst_reader *prev, *next;
+
+    size_t state; /* (epoch << 1) | 1 while active, accessed atomically */
+    size_t nesting;
+};
+
+struct bst_concurrent {
+    int(*comp)(void const *, void const *);
+
+    struct concurrent_node *root; /* accessed atomically */
+    size_t seq;                   /* accessed atomically */
+
+    pthread_mutex_t lock; /* held by writers and while (un)registering */
+
+    size_t epoch; /* accessed atomically */
+    struct bst_reader *readers;
+    struct concurrent_node *retired_first, *retired_last;
+    size_t n_retired; /* accessed atomically */
+};
+
+
+/* atomic accesses */
+
+static struct concurrent_node * load_child(struct concurrent_node **slot)
+{
+    return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+}
+
+static void store_child(struct concurrent_node **slot,
+                        struct concurrent_node *node)
+{
+    __atomic_store_n(slot, node, __ATOMIC_RELEASE);
+}
+
+/* no fence is needed after making the sequence counter odd: child pointers
+   are only modified by release stores and loaded with acquire loads, so a
+   reader which observes any modification also observes the odd counter when
+   it loads the counter again */
+static void write_begin(struct bst_concurrent *t)
+{
+    __atomic_store_n(&t->seq, t->seq + 1u, __ATOMIC_RELAXED);
+}
+
+static void write_end(struct bst_concurrent *t)
+{
+    __atomic_store_n(&t->seq, t->seq + 1u, __ATOMIC_RELEASE);
+}
+
+
+/* creation and destruction */
+
+struct bst_concurrent * bst_concurrent_create(
+    int(*comp)(void const *, void const *))
+{
+    struct bst_concurrent *t = malloc(sizeof(struct bst_concurrent));
+    if (!t)
+        return NULL;
+
+    if (pthread_mutex_init(&t->lock, NULL) != 0) {
+        free(t);
+        return NULL;
+    }
+
+    t->comp = comp;
+    t->root = NULL;
+    t->seq = 0u;
+
+    t->epoch = 0u;
+    t->readers = NULL;
+    t->retired_first = NULL;
+    t->retired_last = NULL;
+    t->n_retired = 0u;
+
+    return t;
+}
+
+static void node_free(struct concurrent_node *node, int free_key,
+                      int free_data)
+{
+    if (free_key)
+        free(node->key);
+
+    if (free_data)
+        free(node->data);
+
+    free(node);
+}
+
+void bst_concurrent_free(struct bst_concurrent *t, int free_keys,
+                         int free_data)
+{
+    if (!t)
+        return;
+
+    /* postorder traversal along parent pointers like bst_free */
+    struct concurrent_node *node = t->root;
+
+    while (node) {
+        if (node->left) {
+            node = node->left;
+            continue;
+        }
+
+        if (node->right) {
+            node = node->right;
+            continue;
+        }
+
+        struct concurrent_node *parent = node->parent;
+
+        if (parent) {
+            if (node == parent->left)
+                parent->left = NULL;
+            else
+                parent->right = NULL;
+        }
+
+        node_free(node, free_keys, free_data);
+
+        node = parent;
+    }
+
+    while (t->retired_first) {
+        node = t->retired_first;
+        t->retired_first = node->next_retired;
+
+        node_free(node, node->free_key, node->free_data);
+    }
+
+    while (t->readers) {
+        struct bst_reader *r = t->readers;
+        t->readers = r->next;
+
+        free(r);
+    }
+
+    pthread_mutex_destroy(&t->lock);
+
+    free(t);
+}
+
+
+/* reclamation */
+
+/* reader states are read with a read-modify-write and announced with an
+   exchange, these are totally ordered so that either the writer observes a
+   reader's announcement or the reader's exchange reads the value written by
+   the writer, which then happens before all of the reader's loads, in which
+   case the reader never sees nodes the writer unlinked before */
+static int can_advance(struct bst_concurrent *t, size_t epoch)
+{
+    for (struct bst_reader *r = t->readers; r; r = r->next) {
+        size_t state = __atomic_fetch_add(&r->state, 0u, __ATOMIC_ACQ_REL);
+
+        if ((state & 1u) && (state >> 1u) != epoch)
+            return 0;
+    }
+
+    return 1;
+}
+
+static void try_reclaim(struct bst_concurrent *t)
+{
+    size_t epoch = t->epoch;
+
+    for (int i = 0; i < 2 && can_advance(t, epoch); ++i) {
+        ++epoch;
+        __atomic_store_n(&t->epoch, epoch, __ATOMIC_SEQ_CST);
+    }
+
+    while (t->retired_first && t->retired_first->retire_epoch + 2u <= epoch) {
+        struct concurrent_node *node = t->retired_first;
+
+        t->retired_first = node->next_retired;
+        if (!t->retired_first)
+            t->retired_last = NULL;
+
+        node_free(node, node->free_key, node->free_data);
+
+        __atomic_store_n(&t->n_retired, t->n_retired - 1u, __ATOMIC_RELAXED);
+    }
+}
+
+static void retire(struct bst_concurrent *t, struct concurrent_node *node,
+                   int free_key, int free_data)
+{
+    node->next_retired = NULL;
+    node->retire_epoch = t->epoch;
+    node->free_key = free_key;
+    node->free_data = free_data;
+
+    if (t->retired_last)
+        t->retired_last->next_retired = node;
+    else
+        t->retired_first = node;
+
+    t->retired_last = node;
+
+    __atomic_store_n(&t->n_retired, t->n_retired + 1u, __ATOMIC_RELAXED);
+
+    try_reclaim(t);
+}
+
+
+/* readers */
+
+struct bst_reader * bst_reader_create(struct bst_concurrent *t)
+{
+    struct bst_reader *r = malloc(sizeof(struct bst_reader));
+    if (!r)
+        return NULL;
+
+    r->t = t;
+    r->prev = NULL;
+    r->state = 0u;
+    r->nesting = 0u;
+
+    pthread_mutex_lock(&t->lock);
+
+    r->next = t->readers;
+    if (t->readers)
+        t->readers->prev = r;
+
+    t->readers = r;
+
+    pthread_mutex_unlock(&t->lock);
+
+    return r;
+}
+
+void bst_reader_free(struct bst_reader *r)
+{
+    if (!r)
+        return;
+
+    struct bst_concurrent *t = r->t;
+
+    pthread_mutex_lock(&t->lock);
+
+    if (r->prev)
+        r->prev->next = r->next;
+    else
+        t->readers = r->next;
+
+    if (r->next)
+        r->next->prev = r->prev;
+
+    pthread_mutex_unlock(&t->lock);
+
+    free(r);
+}
+
+void bst_reader_lock(struct bst_reader *r)
+{
+    if (r->nesting++ > 0u)
+        return;
+
+    size_t epoch = __atomic_load_n(&r->t->epoch, __ATOMIC_ACQUIRE);
+
+    __atomic_exchange_n(&r->state, (epoch << 1u) | 1u, __ATOMIC_ACQ_REL);
+}
+
+void bst_reader_unlock(struct bst_reader *r)
+{
+    if (--r->nesting > 0u)
+        return;
+
+    __atomic_store_n(&r->state, 0u, __ATOMIC_RELEASE);
+
+    /* nodes retired by the last writes may only have been waiting for this
+       reader, readers never wait for writers though */
+    struct bst_concurrent *t = r->t;
+
+    if (__atomic_load_n(&t->n_retired, __ATOMIC_RELAXED) > 0u &&
+        pthread_mutex_trylock(&t->lock) == 0) {
+
+        try_reclaim(t);
+
+        pthread_mutex_unlock(&t->lock);
+    }
+}
+
+
+/* searching */
+
+/* return the node with key or NULL, *valid is set to zero if the walk took
+   more than MAX_DEPTH steps which can only happen while a writer rebalances */
+static struct concurrent_node * find(struct bst_concurrent *t,
+                                     void const *key, int *valid)
+{
+    struct concurrent_node *node = load_child(&t->root);
+
+    for (size_t depth = 0u; node; ++depth) {
+        if (depth == MAX_DEPTH) {
+            *valid = 0;
+            return NULL;
+        }
+
+        int tmp = t->comp(key, node->key);
+
+        if (tmp == 0)
+            return node;
+
+        if (tmp < 0)
+            node = load_child(&node->left);
+        else
+            node = load_child(&node->right);
+    }
+
+    return NULL;
+}
+
+/* return the node with the smallest key greater than key (or the smallest
+   key if key is NULL) or NULL if there is none */
+static struct concurrent_node * find_next(struct bst_concurrent *t,
+                                          void const *key, int *valid)
+{
+    struct concurrent_node *node = load_child(&t->root);
+    struct concurrent_node *next = NULL;
+
+    for (size_t depth = 0u; node; ++depth) {
+        if (depth == MAX_DEPTH) {
+            *valid = 0;
+            return NULL;
+        }
+
+        if (!key || t->comp(key, node->key) < 0) {
+            next = node;
+            node = load_child(&node->left);
+        } else {
+            node = load_child(&node->right);
+        }
+    }
+
+    return next;
+}
+
+/* run lookup until it has not been interfered with by a writer, if
+   accept_found is nonzero nodes which have been found are accepted without
+   validation since they have been part of the tree at some point during the
+   lookup */
+static struct concurrent_node * read_validated(
+    struct bst_reader *r, void const *key,
+    struct concurrent_node *(*lookup)(struct bst_concurrent *, void const *,
+                                      int *),
+    int accept_found)
+{
+    struct bst_concurrent *t = r->t;
+
+    for (size_t attempt = 0u;; ++attempt) {
+        if (attempt >= SPIN_READS)
+            sched_yield();
+
+        size_t seq = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1u)
+            continue;
+
+        int valid = 1;
+        struct concurrent_node *node = lookup(t, key, &valid);
+
+        if (node && accept_found)
+            return node;
+
+        /* this load cannot be reordered before the acquire loads of lookup */
+        if (valid && __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE) == seq)
+            return node;
+    }
+}
+
+int bst_reader_search(struct bst_reader *r, void const *key, void **data)
+{
+    bst_reader_lock(r);
+
+    struct concurrent_node *node = read_validated(r, key, find, 1);
+
+    if (node && data)
+        *data = node->data;
+
+    bst_reader_unlock(r);
+
+    return node != NULL;
+}
+
+int bst_reader_next(struct bst_reader *r, void const *key,
+                    void **next_key, void **data)
+{
+    bst_reader_lock(r);
+
+    struct concurrent_node *node = read_validated(r, key, find_next, 0);
+
+    if (node) {
+        if (next_key)
+            *next_key = node->key;
+
+        if (data)
+            *data = node->data;
+    }
+
+    bst_reader_unlock(r);
+
+    return node != NULL;
+}
+
+
+/* rotations, children are linked before they become reachable through their
+   new parent so that readers never encounter cycles */
+
+static void replace_child(struct bst_concurrent *t,
+                          struct concurrent_node *parent,
+                          struct concurrent_node *node,
+                          struct concurrent_node *replacement)
+{
+    if (!parent)
+        store_child(&t->root, replacement);
+    else if (node == parent->left)
+        store_child(&parent->left, replacement);
+    else
+        store_child(&parent->right, replacement);
+
+    if (replacement)
+        replacement->parent = parent;
+}
+
+static void rotate_left(struct bst_concurrent *t,
+                        struct concurrent_node *node)
+{
+    struct concurrent_node *tmp = node->right;
+
+    store_child(&node->right, tmp->left);
+    if (tmp->left)
+        tmp->left->parent = node;
+
+    replace_child(t, node->parent, node, tmp);
+
+    store_child(&tmp->left, node);
+    node->parent = tmp;
+}
+
+static void rotate_right(struct bst_concurrent *t,
+                         struct concurrent_node *node)
+{
+    struct concurrent_node *tmp = node->left;
+
+    store_child(&node->left, tmp->right);
+    if (tmp->right)
+        tmp->right->parent = node;
+
+    replace_child(t, node->parent, node, tmp);
+
+    store_child(&tmp->right, node);
+    node->parent = tmp;
+}
+
+
+/* insertion */
+
+static int is_red(struct concurrent_node const *node)
+{
+    return node && node->red;
+}
+
+static void insert_fixup(struct bst_concurrent *t,
+                         struct concurrent_node *node)
+{
+    while (is_red(node->parent)) {
+        struct concurrent_node *parent = node->parent;
+        struct concurrent_node *grandparent = parent->parent;
+
+        if (parent == grandparent->left) {
+            struct concurrent_node *uncle = grandparent->right;
+
+            if (is_red(uncle)) {
+                parent->red = 0;
+                uncle->red = 0;
+                grandparent->red = 1;
+                node = grandparent;
+                continue;
+            }
+
+            if (node == parent->right) {
+                rotate_left(t, parent);
+                node = parent;
+                parent = node->parent;
+            }
+
+            parent->red = 0;
+            grandparent->red = 1;
+            rotate_right(t, grandparent);
+
+        } else {
+            struct concurrent_node *uncle = grandparent->left;
+
+            if (is_red(uncle)) {
+                parent->red = 0;
+                uncle->red = 0;
+                grandparent->red = 1;
+                node = grandparent;
+                continue;
+            }
+
+            if (node == parent->left) {
+                rotate_right(t, parent);
+                node = parent;
+                parent = node->parent;
+            }
+
+            parent->red = 0;
+            grandparent->red = 1;
+            rotate_left(t, grandparent);
+        }
+    }
+
+    t->root->red = 0;
+}
+
+int bst_concurrent_insert(struct bst_concurrent *t, void *key, void *data)
+{
+    pthread_mutex_lock(&t->lock);
+
+    struct concurrent_node *current, *parent;
+    parent = NULL;
+    current = t->root;
+
+    int tmp = 0;
+
+    while (current) {
+        parent = current;
+        tmp = t->comp(key, current->key);
+
+        if (tmp == 0) {
+            pthread_mutex_unlock(&t->lock);
+            return 0;
+        }
+
+        if (tmp < 0)
+            current = current->left;
+        else
+            current = current->right;
+    }
+
+    struct concurrent_node *node = malloc(sizeof(struct concurrent_node));
+    if (!node) {
+        pthread_mutex_unlock(&t->lock);
+        return -1;
+    }
+
+    node->left = NULL;
+    node->right = NULL;
+    node->parent = parent;
+    node->key = key;
+    node->data = data;
+    node->red = 1;
+
+    if (t->n_retired > 0u)
+        try_reclaim(t);
+
+    write_begin(t);
+
+    if (!parent)
+        store_child(&t->root, node);
+    else if (tmp < 0)
+        store_child(&parent->left, node);
+    else
+        store_child(&parent->right, node);
+
+    insert_fixup(t, node);
+
+    write_end(t);
+
+    pthread_mutex_unlock(&t->lock);
+
+    return 1;
+}
+
+
+/* deletion */
+
+static void delete_fixup(struct bst_concurrent *t,
+                         struct concurrent_node *node,
+                         struct concurrent_node *parent)
+{
+    while (node != t->root && !is_red(node)) {
+        if (node == parent->left) {
+            struct concurrent_node *sibling = parent->right;
+
+            if (is_red(sibling)) {
+                sibling->red = 0;
+                parent->red = 1;
+                rotate_left(t, parent);
+                sibling = parent->right;
+            }
+
+            if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                sibling->red = 1;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+
+            if (!is_red(sibling->right)) {
+                sibling->left->red = 0;
+                sibling->red = 1;
+                rotate_right(t, sibling);
+                sibling = parent->right;
+            }
+
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->right->red = 0;
+            rotate_left(t, parent);
+
+        } else {
+            struct concurrent_node *sibling = parent->left;
+
+            if (is_red(sibling)) {
+                sibling->red = 0;
+                parent->red = 1;
+                rotate_right(t, parent);
+                sibling = parent->left;
+            }
+
+            if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                sibling->red = 1;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+
+            if (!is_red(sibling->left)) {
+                sibling->right->red = 0;
+                sibling->red = 1;
+                rotate_left(t, sibling);
+                sibling = parent->left;
+            }
+
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->left->red = 0;
+            rotate_right(t, parent);
+        }
+
+        node = t->root;
+    }
+
+    if (node)
+        node->red = 0;
+}
+
+int bst_concurrent_delete(struct bst_concurrent *t, void const *key,
+                          int free_key, int free_data)
+{
+    pthread_mutex_lock(&t->lock);
+
+    int valid = 1;
+    struct concurrent_node *node = find(t, key, &valid);
+
+    if (!node) {
+        pthread_mutex_unlock(&t->lock);
+        return 0;
+    }
+
+    write_begin(t);
+
+    struct concurrent_node *tmp, *parent;
+    int removed_red = node->red;
+
+    if (!node->left) {
+        tmp = node->right;
+        parent = node->parent;
+        replace_child(t, node->parent, node, tmp);
+
+    } else if (!node->right) {
+        tmp = node->left;
+        parent = node->parent;
+        replace_child(t, node->parent, node, tmp);
+
+    } else {
+        struct concurrent_node *succ = node->right;
+        while (succ->left)
+            succ = succ->left;
+
+        removed_red = succ->red;
+
+        tmp = succ->right;
+
+        /* succ is linked to node's children before it replaces node */
+        store_child(&succ->left, node->left);
+        succ->left->parent = succ;
+
+        if (succ->parent == node) {
+            parent = succ;
+        } else {
+            parent = succ->parent;
+            replace_child(t, succ->parent, succ, tmp);
+
+            store_child(&succ->right, node->right);
+            succ->right->parent = succ;
+        }
+
+        replace_child(t, node->parent, node, succ);
+
+        succ->red = node->red;
+    }
+
+    if (!removed_red)
+        delete_fixup(t, tmp, parent);
+
+    write_end(t);
+
+    /* node keeps its children so that readers currently visiting it can
+       continue their walk */
+    retire(t, node, free_key, free_data);
+
+    pthread_mutex_unlock(&t->lock);
+
+    return 1;
+}
@@ -0,0 +1,207 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "binary_search_tree.h"
+
+/* Keys are stored in Eytzinger order (the BFS order of a complete binary
+   tree, the children of position k are 2k and 2k + 1), position 0 is unused.
+   The key array is cache line aligned so that the 8 descendants three levels
+   below any position share one cache line, which is prefetched while the
+   search descends. */
+
+enum { CACHE_LINE = 64 };
+
+struct bst_frozen {
+    int64_t *keys;
+    void **data;
+    size_t size;
+};
+
+
+/* implicit tree navigation */
+
+static size_t frozen_first(size_t size)
+{
+    if (size == 0u)
+        return BST_FROZEN_NONE;
+
+    size_t pos = 1u;
+    while (2u * pos <= size)
+        pos *= 2u;
+
+    return pos;
+}
+
+static size_t frozen_next(size_t size, size_t pos)
+{
+    if (2u * pos + 1u <= size) {
+        pos = 2u * pos + 1u;
+        while (2u * pos <= size)
+            pos *= 2u;
+
+        return pos;
+    }
+
+    while (pos & 1u)
+        pos >>= 1u;
+
+    return pos >> 1u;
+}
+
+
+/* creation and destruction */
+
+static struct bst_frozen * frozen_create(size_t size)
+{
+    struct bst_frozen *f = malloc(sizeof(struct bst_frozen));
+    if (!f)
+        return NULL;
+
+    void *keys;
+    if (posix_memalign(&keys, CACHE_LINE, (size + 1u) * sizeof(int64_t))) {
+        free(f);
+        return NULL;
+    }
+
+    f->keys = keys;
+    f->keys[0] = 0;
+
+    f->data = malloc((size + 1u) * sizeof(void *));
+    if (!f->data) {
+        free(f->keys);
+        free(f);
+        return NULL;
+    }
+
+    f->data[0] = NULL;
+    f->size = size;
+
+    return f;
+}
+
+struct bst_frozen * bst_freeze(struct bst_node *root,
+                               int64_t(*key_value)(void const *key))
+{
+    size_t size = 0u;
+    for (struct bst_node *node = bst_min(root);
+         node;
+         node = bst_successor(node)) {
+
+        ++size;
+    }
+
+    struct bst_frozen *f = frozen_create(size);
+    if (!f)
+        return NULL;
+
+    size_t pos = frozen_first(size);
+
+    for (struct bst_node *node = bst_min(root);
+         node;
+         node = bst_successor(node)) {
+
+        f->keys[pos] = key_value(node->key);
+        f->data[pos] = node->data;
+
+        pos = frozen_next(size, pos);
+    }
+
+    return f;
+}
+
+struct bst_frozen * bst_compact_freeze(struct bst_compact *t)
+{
+    size_t size = bst_compact_size(t);
+
+    struct bst_frozen *f = frozen_create(size);
+    if (!f)
+        return NULL;
+
+    size_t pos = frozen_first(size);
+
+    for (uint32_t node = bst_compact_min(t);
+         node != BST_COMPACT_NIL;
+         node = bst_compact_successor(t, node)) {
+
+        struct bst_compact_node const *tmp = bst_compact_get(t, node);
+
+        f->keys[pos] = tmp->key;
+        f->data[pos] = tmp->data;
+
+        pos = frozen_next(size, pos);
+    }
+
+    return f;
+}
+
+void bst_frozen_free(struct bst_frozen *f)
+{
+    if (!f)
+        return;
+
+    free(f->keys);
+    free(f->data);
+    free(f);
+}
+
+
+/* searching */
+
+size_t bst_frozen_size(struct bst_frozen const *f)
+{
+    return f->size;
+}
+
+size_t bst_frozen_lower_bound(struct bst_frozen const *f, int64_t key)
+{
+    int64_t const *keys = f->keys;
+    size_t size = f->size;
+
+    size_t pos = 1u;
+
+    while (pos <= size) {
+        __builtin_prefetch(keys + 8u * pos);
+        pos = 2u * pos + (keys[pos] < key);
+    }
+
+    /* undo the right turns taken after the last left turn, the node at which
+       that left turn was taken holds the lower bound */
+    pos >>= __builtin_ffsll(~(long long) pos);
+
+    return pos;
+}
+
+size_t bst_frozen_search(struct bst_frozen const *f, int64_t key)
+{
+    size_t pos = bst_frozen_lower_bound(f, key);
+
+    if (pos != BST_FROZEN_NONE && f->keys[pos] != key)
+        return BST_FROZEN_NONE;
+
+    return pos;
+}
+
+int64_t bst_frozen_key(struct bst_frozen const *f, size_t pos)
+{
+    return f->keys[pos];
+}
+
+void * bst_frozen_data(struct bst_frozen const *f, size_t pos)
+{
+    return f->data[pos];
+}
+
+size_t bst_frozen_min(struct bst_frozen const *f)
+{
+    return frozen_first(f->size);
+}
+
+size_t bst_frozen_successor(struct bst_frozen const *f, size_t pos)
+{
+    if (pos == BST_FROZEN_NONE)
+        return BST_FROZEN_NONE;
+
+    return frozen_next(f->size, pos);
+}
@@ -0,0 +1,154 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "binary_search_tree.h"
+#include "binary_search_tree_impl.h"
+
+/* Nodes are carved from slabs in allocation order, slabs double in size up
+   to SLAB_MAX_NODES nodes. Released nodes are kept in a free list and handed
+   out again before any new slab space is used. */
+
+enum {
+    SLAB_MIN_NODES = 64,
+    SLAB_MAX_NODES = 1 << 16
+};
+
+union pool_node {
+    struct rbt_node node;
+    union pool_node *next_free;
+};
+
+struct pool_slab {
+    struct pool_slab *next;
+    size_t size;
+    union pool_node nodes[];
+};
+
+struct bst_pool {
+    struct pool_slab *slabs; /* most recent first */
+    size_t used;             /* nodes handed out from the most recent slab */
+
+    union pool_node *free_list;
+};
+
+
+/* creation and destruction */
+
+struct bst_pool * bst_pool_create(void)
+{
+    struct bst_pool *pool = malloc(sizeof(struct bst_pool));
+    if (!pool)
+        return NULL;
+
+    pool->slabs = NULL;
+    pool->used = 0u;
+    pool->free_list = NULL;
+
+    return pool;
+}
+
+void bst_pool_free(struct bst_pool *pool, struct bst_node *root,
+                   int free_keys, int free_data)
+{
+    if (!pool)
+        return;
+
+    if (free_keys || free_data) {
+        for (struct bst_node *node = bst_min(root);
+             node;
+             node = bst_successor(node)) {
+
+            if (free_keys)
+                free(node->key);
+
+            if (free_data)
+                free(node->data);
+        }
+    }
+
+    struct pool_slab *slab = pool->slabs;
+    while (slab) {
+        struct pool_slab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    free(pool);
+}
+
+
+/* node allocation */
+
+struct bst_node * bst_node_alloc(struct bst_pool *pool, size_t size)
+{
+    if (!pool)
+        return malloc(size);
+
+    union pool_node *node = pool->free_list;
+    if (node) {
+        pool->free_list = node->next_free;
+        return &node->node.node;
+    }
+
+    struct pool_slab *slab = pool->slabs;
+
+    if (!slab || pool->used == slab->size) {
+        size_t slab_size = slab ? 2u * slab->size : SLAB_MIN_NODES;
+        if (slab_size > SLAB_MAX_NODES)
+            slab_size = SLAB_MAX_NODES;
+
+        slab = malloc(sizeof(struct pool_slab) +
+                      slab_size * sizeof(union pool_node));
+        if (!slab)
+            return NULL;
+
+        slab->next = pool->slabs;
+        slab->size = slab_size;
+
+        pool->slabs = slab;
+        pool->used = 0u;
+    }
+
+    return &slab->nodes[pool->used++].node.node;
+}
+
+struct bst_node * bst_node_alloc_array(struct bst_pool *pool, size_t n,
+                                       size_t *stride)
+{
+    if (n > (SIZE_MAX - sizeof(struct pool_slab)) / sizeof(union pool_node))
+        return NULL;
+
+    struct pool_slab *slab = malloc(sizeof(struct pool_slab) +
+                                    n * sizeof(union pool_node));
+    if (!slab)
+        return NULL;
+
+    slab->size = n;
+
+    /* keep handing out nodes from the most recent slab */
+    if (pool->slabs) {
+        slab->next = pool->slabs->next;
+        pool->slabs->next = slab;
+    } else {
+        slab->next = NULL;
+        pool->slabs = slab;
+        pool->used = n;
+    }
+
+    *stride = sizeof(union pool_node);
+
+    return &slab->nodes[0].node.node;
+}
+
+void bst_node_release(struct bst_pool *pool, struct bst_node *node)
+{
+    if (!pool) {
+        free(node);
+        return;
+    }
+
+    union pool_node *tmp = (union pool_node *) node;
+
+    tmp->next_free = pool->free_list;
+    pool->free_list = tmp;
+}
@@ -0,0 +1,353 @@
+#include <stdlib.h>
+
+#include "binary_search_tree.h"
+#include "binary_search_tree_impl.h"
+
+
+/* node colors */
+
+static int is_red(struct bst_node const *node)
+{
+    return node && ((struct rbt_node const *) node)->red;
+}
+
+static void set_red(struct bst_node *node, int red)
+{
+    ((struct rbt_node *) node)->red = red;
+}
+
+
+/* rotations */
+
+static struct bst_node * rotate_left(struct bst_node *root,
+                                     struct bst_node *node)
+{
+    struct bst_node *tmp = node->right;
+
+    node->right = tmp->left;
+    if (tmp->left)
+        tmp->left->parent = node;
+
+    tmp->parent = node->parent;
+
+    if (!node->parent)
+        root = tmp;
+    else if (node == node->parent->left)
+        node->parent->left = tmp;
+    else
+        node->parent->right = tmp;
+
+    tmp->left = node;
+    node->parent = tmp;
+
+    return root;
+}
+
+static struct bst_node * rotate_right(struct bst_node *root,
+                                      struct bst_node *node)
+{
+    struct bst_node *tmp = node->left;
+
+    node->left = tmp->right;
+    if (tmp->right)
+        tmp->right->parent = node;
+
+    tmp->parent = node->parent;
+
+    if (!node->parent)
+        root = tmp;
+    else if (node == node->parent->right)
+        node->parent->right = tmp;
+    else
+        node->parent->left = tmp;
+
+    tmp->right = node;
+    node->parent = tmp;
+
+    return root;
+}
+
+
+/* insertion */
+
+static struct bst_node * insert_fixup(struct bst_node *root,
+                                      struct bst_node *node)
+{
+    /* the root is black so a red parent always has a parent itself */
+    while (is_red(node->parent)) {
+        struct bst_node *parent = node->parent;
+        struct bst_node *grandparent = parent->parent;
+
+        if (parent == grandparent->left) {
+            struct bst_node *uncle = grandparent->right;
+
+            if (is_red(uncle)) {
+                set_red(parent, 0);
+                set_red(uncle, 0);
+                set_red(grandparent, 1);
+                node = grandparent;
+                continue;
+            }
+
+            if (node == parent->right) {
+                root = rotate_left(root, parent);
+                node = parent;
+                parent = node->parent;
+            }
+
+            set_red(parent, 0);
+            set_red(grandparent, 1);
+            root = rotate_right(root, grandparent);
+
+        } else {
+            struct bst_node *uncle = grandparent->left;
+
+            if (is_red(uncle)) {
+                set_red(parent, 0);
+                set_red(uncle, 0);
+                set_red(grandparent, 1);
+                node = grandparent;
+                continue;
+            }
+
+            if (node == parent->left) {
+                root = rotate_right(root, parent);
+                node = parent;
+                parent = node->parent;
+            }
+
+            set_red(parent, 0);
+            set_red(grandparent, 1);
+            root = rotate_left(root, grandparent);
+        }
+    }
+
+    set_red(root, 0);
+
+    return root;
+}
+
+struct bst_node * rbt_insert(struct bst_node *root, void *key, void *data,
+                             int(*comp)(void const *, void const *))
+{
+    return rbt_pool_insert(NULL, root, key, data, comp);
+}
+
+struct bst_node * rbt_pool_insert(struct bst_pool *pool,
+                                  struct bst_node *root, void *key, void *data,
+                                  int(*comp)(void const *, void const *))
+{
+    struct bst_node *current, *parent;
+    parent = NULL;
+    current = root;
+
+    int less = 0;
+
+    while (current) {
+        parent = current;
+        less = comp(key, current->key) < 0;
+
+        if (less)
+            current = current->left;
+        else
+            current = current->right;
+    }
+
+    return rbt_pool_insert_at(pool, root, parent, less, key, data);
+}
+
+struct bst_node * rbt_pool_insert_at(struct bst_pool *pool,
+                                     struct bst_node *root,
+                                     struct bst_node *parent, int left,
+                                     void *key, void *data)
+{
+    struct bst_node *node = bst_node_alloc(pool, sizeof(struct rbt_node));
+    if (!node)
+        return NULL;
+
+    node->key = key;
+    node->data = data;
+
+    return rbt_link(root, parent, left, node);
+}
+
+struct bst_node * rbt_link(struct bst_node *root, struct bst_node *parent,
+                           int left, struct bst_node *node)
+{
+    node->left = NULL;
+    node->right = NULL;
+    node->parent = parent;
+
+    set_red(node, 1);
+
+    if (!parent)
+        root = node;
+    else if (left)
+        parent->left = node;
+    else
+        parent->right = node;
+
+    return insert_fixup(root, node);
+}
+
+
+/* deletion */
+
+static struct bst_node * transplant(struct bst_node *root,
+                                    struct bst_node *node,
+                                    struct bst_node *replacement)
+{
+    if (!node->parent)
+        root = replacement;
+    else if (node == node->parent->left)
+        node->parent->left = replacement;
+    else
+        node->parent->right = replacement;
+
+    if (replacement)
+        replacement->parent = node->parent;
+
+    return root;
+}
+
+/* node carries an extra black, it may be NULL in which case parent is needed
+   to locate it in the tree */
+static struct bst_node * delete_fixup(struct bst_node *root,
+                                      struct bst_node *node,
+                                      struct bst_node *parent)
+{
+    while (node != root && !is_red(node)) {
+        /* the sibling of a node with an extra black is never NULL */
+        if (node == parent->left) {
+            struct bst_node *sibling = parent->right;
+
+            if (is_red(sibling)) {
+                set_red(sibling, 0);
+                set_red(parent, 1);
+                root = rotate_left(root, parent);
+                sibling = parent->right;
+            }
+
+            if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                set_red(sibling, 1);
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+
+            if (!is_red(sibling->right)) {
+                set_red(sibling->left, 0);
+                set_red(sibling, 1);
+                root = rotate_right(root, sibling);
+                sibling = parent->right;
+            }
+
+            set_red(sibling, is_red(parent));
+            set_red(parent, 0);
+            set_red(sibling->right, 0);
+            root = rotate_left(root, parent);
+
+        } else {
+            struct bst_node *sibling = parent->left;
+
+            if (is_red(sibling)) {
+                set_red(sibling, 0);
+                set_red(parent, 1);
+                root = rotate_right(root, parent);
+                sibling = parent->left;
+            }
+
+            if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                set_red(sibling, 1);
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+
+            if (!is_red(sibling->left)) {
+                set_red(sibling->right, 0);
+                set_red(sibling, 1);
+                root = rotate_left(root, sibling);
+                sibling = parent->left;
+            }
+
+            set_red(sibling, is_red(parent));
+            set_red(parent, 0);
+            set_red(sibling->left, 0);
+            root = rotate_right(root, parent);
+        }
+
+        node = root;
+    }
+
+    if (node)
+        set_red(node, 0);
+
+    return root;
+}
+
+struct bst_node * rbt_delete(struct bst_node *root, struct bst_node *node,
+                             int free_key, int free_data)
+{
+    return rbt_pool_delete(NULL, root, node, free_key, free_data);
+}
+
+struct bst_node * rbt_pool_delete(struct bst_pool *pool,
+                                  struct bst_node *root, struct bst_node *node,
+                                  int free_key, int free_data)
+{
+    if (!root || !node)
+        return NULL;
+
+    struct bst_node *tmp, *parent;
+    int removed_red = is_red(node);
+
+    if (!node->left) {
+        tmp = node->right;
+        parent = node->parent;
+        root = transplant(root, node, tmp);
+
+    } else if (!node->right) {
+        tmp = node->left;
+        parent = node->parent;
+        root = transplant(root, node, tmp);
+
+    } else {
+        /* unlike bst_delete, node's successor takes its place in the tree
+           instead of its key and data, so no other node is invalidated */
+        struct bst_node *succ = bst_min(node->right);
+        removed_red = is_red(succ);
+
+        tmp = succ->right;
+
+        if (succ->parent == node) {
+            parent = succ;
+        } else {
+            parent = succ->parent;
+            root = transplant(root, succ, tmp);
+
+            succ->right = node->right;
+            succ->right->parent = succ;
+        }
+
+        root = transplant(root, node, succ);
+
+        succ->left = node->left;
+        succ->left->parent = succ;
+
+        set_red(succ, is_red(node));
+    }
+
+    if (free_key)
+        free(node->key);
+
+    if (free_data)
+        free(node->data);
+
+    bst_node_release(pool, node);
+
+    if (!removed_red)
+        root = delete_fixup(root, tmp, parent);
+
+    return root;
+}
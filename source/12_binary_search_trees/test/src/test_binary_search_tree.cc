@@ -1,5 +1,11 @@
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdlib>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -8,8 +14,11 @@ extern "C" {
 #include "binary_search_tree.h"
 }
 
+#include "binary_search_tree.hpp"
+
 using ::testing::TestWithParam;
 using ::testing::Values;
+using ::testing::ValuesIn;
 
 
 TEST(EmptyBinarySearchTreeTest, CanOperateOnEmptyTree)
@@ -75,19 +84,48 @@ protected:
     }
 };
 
-INSTANTIATE_TEST_CASE_P(BinarySearchTrees, BinarySearchTreeTest, Values(
-    std::vector<int>({3, 4, 2, 2, 3}),
-    std::vector<int>({1, 3, 0, 3, 2}),
-    std::vector<int>({5, 5, 0, 5, 2}),
-    std::vector<int>({1, 3, 0, 3, 1}),
-    std::vector<int>({2, 7, 5, 10, 1, 5, 7, 1, 8, 0}),
-    std::vector<int>({8, 10, 3, 2, 6, 10, 10, 10, 7, 8}),
-    std::vector<int>({2, 6, 5, 3, 4, 6, 3, 9, 4, 2}),
-    std::vector<int>({10, 8, 2, 8, 4, 5, 10, 9, 9, 8}),
-    std::vector<int>({9, 4, 10, 13, 10, 4, 1, 3, 8, 4, 1, 13, 10, 7, 15}),
-    std::vector<int>({7, 10, 10, 4, 11, 7, 6, 12, 14, 12, 5, 5, 4, 11, 7}),
-    std::vector<int>({13, 0, 0, 11, 10, 0, 0, 13, 8, 0, 5, 5, 1, 2, 4}),
-    std::vector<int>({3, 15, 9, 1, 5, 14, 3, 14, 10, 15, 0, 9, 14, 14, 11})));
+static std::vector<std::vector<int>> const test_keys = {
+    {3, 4, 2, 2, 3},
+    {1, 3, 0, 3, 2},
+    {5, 5, 0, 5, 2},
+    {1, 3, 0, 3, 1},
+    {2, 7, 5, 10, 1, 5, 7, 1, 8, 0},
+    {8, 10, 3, 2, 6, 10, 10, 10, 7, 8},
+    {2, 6, 5, 3, 4, 6, 3, 9, 4, 2},
+    {10, 8, 2, 8, 4, 5, 10, 9, 9, 8},
+    {9, 4, 10, 13, 10, 4, 1, 3, 8, 4, 1, 13, 10, 7, 15},
+    {7, 10, 10, 4, 11, 7, 6, 12, 14, 12, 5, 5, 4, 11, 7},
+    {13, 0, 0, 11, 10, 0, 0, 13, 8, 0, 5, 5, 1, 2, 4},
+    {3, 15, 9, 1, 5, 14, 3, 14, 10, 15, 0, 9, 14, 14, 11}
+};
+
+static int intcomp(void const *lhs_ptr, void const *rhs_ptr)
+{
+    int lhs = *static_cast<int const *>(lhs_ptr);
+    int rhs = *static_cast<int const *>(rhs_ptr);
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static std::size_t height(struct bst_node const *node)
+{
+    if (!node)
+        return 0u;
+
+    return 1u + std::max(height(node->left), height(node->right));
+}
+
+static std::vector<int> keys(struct bst_node *root)
+{
+    std::vector<int> ret;
+    for (auto node = bst_min(root); node; node = bst_successor(node))
+        ret.push_back(*static_cast<int *>(node->key));
+
+    return ret;
+}
+
+INSTANTIATE_TEST_CASE_P(BinarySearchTrees, BinarySearchTreeTest,
+                        ValuesIn(test_keys));
 
 TEST_P(BinarySearchTreeTest, CanDeleteFromTree)
 {
@@ -269,3 +307,845 @@ TEST_P(BinarySearchTreeTest, CanIterateTree)
 
     bst_iter_free(it);
 }
+
+
+TEST_P(BinarySearchTreeTest, CanFreezeTree)
+{
+    auto expected = GetParam();
+    std::sort(expected.begin(), expected.end());
+
+    auto key_value = [](void const *key) {
+        return static_cast<int64_t>(*static_cast<int const *>(key));
+    };
+
+    auto frozen = bst_freeze(bst_root, key_value);
+    ASSERT_NE(frozen, nullptr)
+        << "Frozen BST created.";
+
+    ASSERT_EQ(bst_frozen_size(frozen), expected.size())
+        << "Frozen BST has correct size.";
+
+    auto pos = bst_frozen_min(frozen);
+    for (auto i = 0u; i < expected.size(); ++i) {
+        ASSERT_NE(pos, BST_FROZEN_NONE)
+            << "Frozen BST successor (" << i << ") is valid.";
+
+        ASSERT_EQ(bst_frozen_key(frozen, pos), expected[i])
+            << "Frozen BST successor (" << i << ") has correct key.";
+
+        pos = bst_frozen_successor(frozen, pos);
+    }
+
+    EXPECT_EQ(pos, BST_FROZEN_NONE)
+        << "Frozen BST maximum has no successor.";
+
+    for (int key = expected.front() - 1; key <= expected.back() + 1; ++key) {
+        auto lb = std::lower_bound(expected.begin(), expected.end(), key);
+
+        auto found = bst_frozen_lower_bound(frozen, key);
+
+        if (lb == expected.end()) {
+            EXPECT_EQ(found, BST_FROZEN_NONE)
+                << "Frozen BST has no lower bound for " << key << ".";
+        } else {
+            ASSERT_NE(found, BST_FROZEN_NONE)
+                << "Frozen BST has lower bound for " << key << ".";
+
+            EXPECT_EQ(bst_frozen_key(frozen, found), *lb)
+                << "Frozen BST lower bound for " << key << " is correct.";
+
+            /* the lower bound is the first of all equal keys */
+            auto rank = 0u;
+            for (auto pos = bst_frozen_min(frozen);
+                 pos != found;
+                 pos = bst_frozen_successor(frozen, pos)) {
+                ++rank;
+            }
+
+            EXPECT_EQ(rank, lb - expected.begin())
+                << "Frozen BST lower bound for " << key << " has correct rank.";
+        }
+
+        bool present = std::binary_search(expected.begin(), expected.end(), key);
+
+        auto match = bst_frozen_search(frozen, key);
+        if (present) {
+            ASSERT_NE(match, BST_FROZEN_NONE)
+                << "Frozen BST contains " << key << ".";
+
+            auto node = bst_search(bst_root, &key, intcomp);
+            EXPECT_EQ(bst_frozen_data(frozen, match), node->data)
+                << "Frozen BST has correct data for " << key << ".";
+        } else {
+            EXPECT_EQ(match, BST_FROZEN_NONE)
+                << "Frozen BST does not contain " << key << ".";
+        }
+    }
+
+    bst_frozen_free(frozen);
+}
+
+class RedBlackTreeTest : public BinarySearchTreeTest
+{
+protected:
+    void SetUp() override {
+        for (int i : GetParam()) {
+            int *i_ptr = static_cast<int *>(malloc(sizeof(int)));
+            *i_ptr = i;
+
+            bst_root = rbt_insert(bst_root, i_ptr, nullptr, intcomp);
+        }
+    }
+
+    static std::size_t max_height(std::size_t size) {
+        return static_cast<std::size_t>(2.0 * std::log2(size + 1u));
+    }
+};
+
+INSTANTIATE_TEST_CASE_P(RedBlackTrees, RedBlackTreeTest, ValuesIn(test_keys));
+
+TEST_P(RedBlackTreeTest, CanIterateTree)
+{
+    auto expected = GetParam();
+    std::sort(expected.begin(), expected.end());
+
+    EXPECT_LE(height(bst_root), max_height(expected.size()))
+        << "Red-black tree is balanced.";
+
+    auto it = bst_iter_create(bst_root);
+    for (auto i = 0u; i < expected.size(); ++i) {
+        struct bst_node *next = bst_iter_next(it);
+        ASSERT_NE(next, nullptr)
+            << "Red-black tree iterator's next node (" << i << ") is valid.";
+
+        ASSERT_EQ(*static_cast<int *>(next->key), expected[i])
+            << "Red-black tree iterator's next node (" << i << ") has correct key.";
+
+        auto pred = bst_predecessor(next);
+        if (i > 0u) {
+            ASSERT_NE(pred, nullptr)
+                << "Red-black tree node predecessor exists.";
+
+            EXPECT_EQ(*static_cast<int *>(pred->key), expected[i - 1u])
+                << "Red-black tree node predecessor has correct key.";
+        } else {
+            EXPECT_EQ(pred, nullptr)
+                << "Red-black tree minimum node has no predecessor.";
+        }
+    }
+
+    EXPECT_EQ(bst_iter_next(it), nullptr)
+        << "Exhausted red-black tree iterator yields null pointer.";
+
+    bst_iter_free(it);
+}
+
+TEST_P(RedBlackTreeTest, CanDeleteFromTree)
+{
+    auto vect = GetParam();
+
+    for (auto it = vect.begin(); it != vect.end(); ++it) {
+        int key = *it;
+
+        auto node = bst_search(bst_root, &key, intcomp);
+        ASSERT_NE(node, nullptr)
+            << "Red-black tree node to delete found.";
+
+        bst_root = rbt_delete(bst_root, node, 1, 0);
+
+        std::vector<int> remaining(it + 1, vect.end());
+        std::sort(remaining.begin(), remaining.end());
+
+        ASSERT_LE(height(bst_root), max_height(remaining.size()))
+            << "Red-black tree stays balanced after deletion.";
+
+        if (bst_root) {
+            ASSERT_EQ(bst_root->parent, nullptr)
+                << "Red-black tree root has no parent.";
+        }
+
+        auto bst_it = bst_iter_create(bst_root);
+
+        for (auto key_remaining : remaining) {
+            struct bst_node *next = bst_iter_next(bst_it);
+            ASSERT_NE(next, nullptr)
+                << "Red-black tree iterator's next node is valid.";
+
+            ASSERT_EQ(*static_cast<int *>(next->key), key_remaining)
+                << "Red-black tree iterator returns correct next nodes for reducted tree.";
+        }
+
+        EXPECT_EQ(bst_iter_next(bst_it), nullptr)
+            << "Red-black tree iterator is exhausted.";
+
+        bst_iter_free(bst_it);
+    }
+}
+
+TEST(LargeRedBlackTreeTest, CanInsertSortedKeys)
+{
+    enum { SIZE = 1 << 16 };
+
+    std::vector<int> keys(SIZE);
+    for (int i = 0; i < SIZE; ++i)
+        keys[i] = i;
+
+    struct bst_node *root = nullptr;
+    for (auto &key : keys)
+        root = rbt_insert(root, &key, nullptr, intcomp);
+
+    std::size_t depth = 0u;
+    for (auto node = bst_max(root); node; node = node->parent)
+        ++depth;
+
+    EXPECT_LE(depth, 2u * 17u)
+        << "Red-black tree built from sorted keys is balanced.";
+
+    for (int i = 0; i < SIZE; i += 2) {
+        auto node = bst_search(root, &keys[i], intcomp);
+        ASSERT_NE(node, nullptr)
+            << "Red-black tree node " << i << " found.";
+
+        root = rbt_delete(root, node, 0, 0);
+    }
+
+    int expected = 1;
+    for (auto node = bst_min(root); node; node = bst_successor(node)) {
+        ASSERT_EQ(*static_cast<int *>(node->key), expected)
+            << "Red-black tree successors are correct after deletion.";
+
+        expected += 2;
+    }
+
+    EXPECT_EQ(expected, SIZE + 1)
+        << "Red-black tree contains all remaining keys.";
+
+    bst_free(root, 0, 0);
+}
+
+TEST(BinarySearchTreePoolTest, CanAllocateFromPool)
+{
+    enum { SIZE = 10000 };
+
+    for (int balanced = 0; balanced < 2; ++balanced) {
+        auto insert = balanced ? rbt_pool_insert : bst_pool_insert;
+        auto remove = balanced ? rbt_pool_delete : bst_pool_delete;
+
+        auto pool = bst_pool_create();
+        ASSERT_NE(pool, nullptr)
+            << "BST node pool created.";
+
+        struct bst_node *root = nullptr;
+
+        for (int i = 0; i < SIZE; ++i) {
+            int *key = static_cast<int *>(malloc(sizeof(int)));
+            *key = (i * 7919) % SIZE;
+
+            root = insert(pool, root, key, nullptr, intcomp);
+            ASSERT_NE(root, nullptr)
+                << "Pooled BST node allocated.";
+        }
+
+        for (int i = 0; i < SIZE; i += 2) {
+            auto node = bst_search(root, &i, intcomp);
+            ASSERT_NE(node, nullptr)
+                << "Pooled BST node " << i << " found.";
+
+            root = remove(pool, root, node, 1, 0);
+        }
+
+        int expected = 1;
+        for (auto node = bst_min(root); node; node = bst_successor(node)) {
+            ASSERT_EQ(*static_cast<int *>(node->key), expected)
+                << "Pooled BST contains correct keys.";
+
+            expected += 2;
+        }
+
+        EXPECT_EQ(expected, SIZE + 1)
+            << "Pooled BST contains all remaining keys.";
+
+        auto max_node = bst_max(root);
+        root = remove(pool, root, max_node, 1, 0);
+
+        int *key = static_cast<int *>(malloc(sizeof(int)));
+        *key = SIZE;
+
+        root = insert(pool, root, key, nullptr, intcomp);
+
+        EXPECT_EQ(bst_search(root, key, intcomp), max_node)
+            << "Released pooled BST node is reused.";
+
+        bst_pool_free(pool, root, 1, 0);
+    }
+}
+
+class CompactTreeTest : public TestWithParam<std::vector<int>>
+{
+protected:
+    void SetUp() {
+        tree = bst_compact_create(0u);
+
+        for (int i : GetParam())
+            bst_compact_insert(tree, i, nullptr);
+    }
+
+    void TearDown() {
+        bst_compact_free(tree, 0);
+    }
+
+    struct bst_compact *tree = nullptr;
+};
+
+INSTANTIATE_TEST_CASE_P(CompactTrees, CompactTreeTest, ValuesIn(test_keys));
+
+TEST_P(CompactTreeTest, CanSearchTree)
+{
+    auto expected = GetParam();
+
+    EXPECT_EQ(bst_compact_size(tree), expected.size())
+        << "Compact tree has correct size.";
+
+    for (auto key : expected) {
+        auto node = bst_compact_search(tree, key);
+        ASSERT_NE(node, BST_COMPACT_NIL)
+            << "Compact tree search returns valid node.";
+
+        EXPECT_EQ(bst_compact_get(tree, node)->key, key)
+            << "Compact tree search returns correct node.";
+    }
+
+    EXPECT_EQ(bst_compact_search(tree, -1), BST_COMPACT_NIL)
+        << "Compact tree search for missing key yields BST_COMPACT_NIL.";
+}
+
+TEST_P(CompactTreeTest, CanDeleteFromTree)
+{
+    auto vect = GetParam();
+
+    for (auto it = vect.begin(); it != vect.end(); ++it) {
+        auto node = bst_compact_search(tree, *it);
+        ASSERT_NE(node, BST_COMPACT_NIL)
+            << "Compact tree node to delete found.";
+
+        bst_compact_delete(tree, node, 0);
+
+        std::vector<int> remaining(it + 1, vect.end());
+        std::sort(remaining.begin(), remaining.end());
+
+        auto next = bst_compact_min(tree);
+
+        for (auto i = 0u; i < remaining.size(); ++i) {
+            ASSERT_NE(next, BST_COMPACT_NIL)
+                << "Compact tree successor is valid.";
+
+            ASSERT_EQ(bst_compact_get(tree, next)->key, remaining[i])
+                << "Compact tree successors are correct for reducted tree.";
+
+            if (i > 0u) {
+                auto pred = bst_compact_predecessor(tree, next);
+                ASSERT_NE(pred, BST_COMPACT_NIL)
+                    << "Compact tree predecessor is valid.";
+
+                EXPECT_EQ(bst_compact_get(tree, pred)->key, remaining[i - 1u])
+                    << "Compact tree predecessors are correct for reducted tree.";
+            }
+
+            next = bst_compact_successor(tree, next);
+        }
+
+        EXPECT_EQ(next, BST_COMPACT_NIL)
+            << "Compact tree maximum has no successor.";
+    }
+}
+
+TEST_P(CompactTreeTest, CanFreezeTree)
+{
+    auto expected = GetParam();
+    std::sort(expected.begin(), expected.end());
+
+    auto frozen = bst_compact_freeze(tree);
+    ASSERT_NE(frozen, nullptr)
+        << "Frozen compact tree created.";
+
+    std::vector<int> keys;
+    for (auto pos = bst_frozen_min(frozen);
+         pos != BST_FROZEN_NONE;
+         pos = bst_frozen_successor(frozen, pos)) {
+        keys.push_back(static_cast<int>(bst_frozen_key(frozen, pos)));
+    }
+
+    EXPECT_EQ(keys, expected)
+        << "Frozen compact tree contains correct keys.";
+
+    for (auto key : expected) {
+        EXPECT_NE(bst_frozen_search(frozen, key), BST_FROZEN_NONE)
+            << "Frozen compact tree contains " << key << ".";
+    }
+
+    bst_frozen_free(frozen);
+}
+
+TEST(LargeCompactTreeTest, CanInsertSortedKeys)
+{
+    enum { SIZE = 1 << 16 };
+
+    EXPECT_LE(sizeof(struct bst_compact_node), 32u)
+        << "Compact tree nodes take at most 32 bytes.";
+
+    auto tree = bst_compact_create(SIZE);
+    ASSERT_NE(tree, nullptr)
+        << "Compact tree created.";
+
+    for (int64_t i = 0; i < SIZE; ++i)
+        ASSERT_NE(bst_compact_insert(tree, i, nullptr), BST_COMPACT_NIL)
+            << "Compact tree node inserted.";
+
+    std::size_t depth = 0u;
+    for (auto node = bst_compact_max(tree);
+         node != BST_COMPACT_NIL;
+         node = bst_compact_get(tree, node)->parent) {
+        ++depth;
+    }
+
+    EXPECT_LE(depth, 2u * 17u)
+        << "Compact tree built from sorted keys is balanced.";
+
+    for (int64_t i = 0; i < SIZE; i += 2)
+        bst_compact_delete(tree, bst_compact_search(tree, i), 0);
+
+    /* deleted nodes are reused */
+    for (int64_t i = 0; i < SIZE; i += 2) {
+        auto node = bst_compact_insert(tree, -i, nullptr);
+        ASSERT_LT(node, static_cast<uint32_t>(SIZE + 1))
+            << "Compact tree reuses deleted nodes.";
+    }
+
+    int64_t expected = -(SIZE - 2);
+    for (auto node = bst_compact_min(tree);
+         node != BST_COMPACT_NIL;
+         node = bst_compact_successor(tree, node)) {
+
+        ASSERT_EQ(bst_compact_get(tree, node)->key, expected)
+            << "Compact tree successors are correct.";
+
+        expected += expected < 0 ? 2 : expected == 0 ? 1 : 2;
+    }
+
+    EXPECT_EQ(expected, SIZE + 1)
+        << "Compact tree contains all keys.";
+
+    bst_compact_free(tree, 0);
+}
+
+class TemplateTreeTest : public TestWithParam<std::vector<int>> {};
+
+INSTANTIATE_TEST_CASE_P(TemplateTrees, TemplateTreeTest, ValuesIn(test_keys));
+
+TEST_P(TemplateTreeTest, CanUseInlineKeys)
+{
+    auto vect = GetParam();
+
+    bst<int, long> tree;
+
+    for (auto key : vect)
+        tree.insert(key, 10L * key);
+
+    EXPECT_EQ(tree.size(), vect.size())
+        << "Template tree has correct size.";
+
+    for (auto key : vect) {
+        auto it = tree.find(key);
+        ASSERT_NE(it, tree.end())
+            << "Template tree search returns valid node.";
+
+        EXPECT_EQ(it.key(), key)
+            << "Template tree search returns correct key.";
+
+        EXPECT_EQ(it.value(), 10L * key)
+            << "Template tree search returns correct value.";
+    }
+
+    EXPECT_FALSE(tree.contains(-1))
+        << "Template tree does not contain missing key.";
+
+    for (auto it = vect.begin(); it != vect.end(); ++it) {
+        ASSERT_TRUE(tree.erase(*it))
+            << "Template tree key erased.";
+
+        std::vector<int> remaining(it + 1, vect.end());
+        std::sort(remaining.begin(), remaining.end());
+
+        std::vector<int> keys;
+        for (auto node = tree.begin(); node != tree.end(); ++node)
+            keys.push_back(node.key());
+
+        ASSERT_EQ(keys, remaining)
+            << "Template tree iterates over remaining keys in order.";
+    }
+
+    EXPECT_TRUE(tree.empty())
+        << "Template tree is empty after erasing all keys.";
+}
+
+TEST_P(TemplateTreeTest, CanUseAllocatedKeys)
+{
+    auto vect = GetParam();
+
+    bst<std::string, std::string, std::greater<std::string>> tree;
+
+    for (auto key : vect)
+        tree.insert(std::to_string(key), "value " + std::to_string(key));
+
+    std::vector<std::string> expected;
+    for (auto key : vect)
+        expected.push_back(std::to_string(key));
+
+    std::sort(expected.begin(), expected.end(), std::greater<std::string>());
+
+    std::vector<std::string> keys;
+    for (auto node = tree.begin(); node != tree.end(); ++node) {
+        keys.push_back(node.key());
+
+        EXPECT_EQ(node.value(), "value " + node.key())
+            << "Template tree stores correct values.";
+    }
+
+    EXPECT_EQ(keys, expected)
+        << "Template tree iterates in comparator order.";
+
+    auto it = tree.find(std::to_string(vect[0]));
+    ASSERT_NE(it, tree.end())
+        << "Template tree search returns valid node.";
+
+    it.value() = "changed";
+    EXPECT_EQ(tree.find(std::to_string(vect[0])).value(), "changed")
+        << "Template tree values can be modified in place.";
+
+    tree.clear();
+
+    EXPECT_TRUE(tree.empty())
+        << "Template tree is empty after clearing.";
+
+    tree.insert("key", "value");
+
+    EXPECT_TRUE(tree.contains("key"))
+        << "Template tree can be reused after clearing.";
+
+    auto moved = std::move(tree);
+
+    EXPECT_TRUE(moved.contains("key"))
+        << "Template tree keys are moved.";
+
+    EXPECT_TRUE(tree.empty())
+        << "Moved from template tree is empty.";
+
+    tree.insert("other key", "other value");
+
+    EXPECT_EQ(tree.find("other key").value(), "other value")
+        << "Moved from template tree can be reused.";
+
+    tree = std::move(moved);
+
+    EXPECT_TRUE(tree.contains("key") && !tree.contains("other key"))
+        << "Template tree keys are move assigned.";
+
+    EXPECT_TRUE(moved.empty())
+        << "Move assigned from template tree is empty.";
+
+    moved.insert("key", "value");
+    tree = decltype(tree)();
+
+    EXPECT_TRUE(tree.empty())
+        << "Template tree is empty after assigning an empty tree.";
+
+    EXPECT_TRUE(moved.contains("key"))
+        << "Move assigned from template tree can be reused.";
+}
+
+class BulkLoadTest : public TestWithParam<std::vector<int>> {};
+
+INSTANTIATE_TEST_CASE_P(BulkLoads, BulkLoadTest, ValuesIn(test_keys));
+
+TEST_P(BulkLoadTest, CanBuildFromSortedKeys)
+{
+    auto expected = GetParam();
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<void *> key_ptrs, data_ptrs;
+    for (auto &key : expected) {
+        key_ptrs.push_back(&key);
+        data_ptrs.push_back(&key + 1);
+    }
+
+    auto pool = bst_pool_create();
+
+    auto root = bst_pool_build(pool, key_ptrs.data(), data_ptrs.data(),
+                               expected.size());
+    ASSERT_NE(root, nullptr)
+        << "BST built from sorted keys.";
+
+    EXPECT_EQ(keys(root), expected)
+        << "Built BST contains correct keys.";
+
+    EXPECT_EQ(height(root),
+              static_cast<std::size_t>(std::ceil(std::log2(expected.size() + 1u))))
+        << "Built BST is perfectly balanced.";
+
+    for (auto node = bst_min(root); node; node = bst_successor(node)) {
+        EXPECT_EQ(node->data, static_cast<int *>(node->key) + 1)
+            << "Built BST has correct data.";
+    }
+
+    /* built trees are valid red-black trees */
+    int extra[] = { expected.back(), expected.front() };
+    for (auto &key : extra)
+        root = rbt_pool_insert(pool, root, &key, nullptr, intcomp);
+
+    while (root) {
+        root = rbt_pool_delete(pool, root, root, 0, 0);
+
+        EXPECT_LE(height(root), static_cast<std::size_t>(
+                  2.0 * std::log2(keys(root).size() + 1u)))
+            << "Built BST stays balanced.";
+    }
+
+    bst_pool_free(pool, nullptr, 0, 0);
+}
+
+TEST_P(BulkLoadTest, CanInsertBatches)
+{
+    auto vect = GetParam();
+
+    for (auto split = 0u; split <= vect.size(); ++split) {
+        std::vector<void *> key_ptrs;
+        for (auto &key : vect)
+            key_ptrs.push_back(&key);
+
+        auto pool = bst_pool_create();
+
+        struct bst_node *root = nullptr;
+        for (auto i = 0u; i < split; ++i)
+            root = rbt_pool_insert(pool, root, key_ptrs[i], nullptr, intcomp);
+
+        root = rbt_pool_insert_batch(pool, root,
+                                     key_ptrs.data() + split, nullptr,
+                                     vect.size() - split, intcomp);
+        ASSERT_NE(root, nullptr)
+            << "Batch inserted into BST.";
+
+        auto expected = vect;
+        std::sort(expected.begin(), expected.end());
+
+        EXPECT_EQ(keys(root), expected)
+            << "BST contains correct keys after batch insertion.";
+
+        EXPECT_LE(height(root), static_cast<std::size_t>(
+                  2.0 * std::log2(vect.size() + 1u)))
+            << "BST is balanced after batch insertion.";
+
+        bst_pool_free(pool, nullptr, 0, 0);
+    }
+}
+
+TEST(LargeBulkLoadTest, CanInsertSmallBatch)
+{
+    enum { SIZE = 1 << 14, BATCH = 16 };
+
+    std::vector<int> keys(SIZE + BATCH);
+    std::vector<void *> key_ptrs(SIZE + BATCH);
+
+    for (int i = 0; i < SIZE + BATCH; ++i) {
+        keys[i] = i < SIZE ? 2 * i : 2 * (SIZE + BATCH - i) - 1;
+        key_ptrs[i] = &keys[i];
+    }
+
+    /* unpooled trees can be extended by batches too */
+    struct bst_node *root = rbt_pool_insert_batch(nullptr, nullptr,
+                                                  key_ptrs.data(), nullptr,
+                                                  SIZE, intcomp);
+    ASSERT_NE(root, nullptr)
+        << "Large batch inserted into empty BST.";
+
+    root = rbt_pool_insert_batch(nullptr, root,
+                                 key_ptrs.data() + SIZE, nullptr,
+                                 BATCH, intcomp);
+    ASSERT_NE(root, nullptr)
+        << "Small batch inserted into large BST.";
+
+    auto expected = keys;
+    std::sort(expected.begin(), expected.end());
+
+    auto node = bst_min(root);
+    for (auto key : expected) {
+        ASSERT_NE(node, nullptr)
+            << "BST contains all keys after batch insertion.";
+
+        ASSERT_EQ(*static_cast<int *>(node->key), key)
+            << "BST contains correct keys after batch insertion.";
+
+        node = bst_successor(node);
+    }
+
+    bst_free(root, 0, 0);
+}
+
+class ConcurrentTreeTest : public TestWithParam<std::vector<int>>
+{
+protected:
+    static std::vector<int> keys(struct bst_reader *r) {
+        std::vector<int> ret;
+
+        bst_reader_lock(r);
+
+        void *key = nullptr;
+        while (bst_reader_next(r, key, &key, nullptr))
+            ret.push_back(*static_cast<int *>(key));
+
+        bst_reader_unlock(r);
+
+        return ret;
+    }
+};
+
+INSTANTIATE_TEST_CASE_P(ConcurrentTrees, ConcurrentTreeTest,
+                        ValuesIn(test_keys));
+
+TEST_P(ConcurrentTreeTest, CanInsertAndDelete)
+{
+    auto vect = GetParam();
+
+    auto tree = bst_concurrent_create(intcomp);
+    ASSERT_NE(tree, nullptr)
+        << "Concurrent tree created.";
+
+    auto reader = bst_reader_create(tree);
+    ASSERT_NE(reader, nullptr)
+        << "Concurrent tree reader created.";
+
+    std::vector<int> unique;
+
+    for (auto key : vect) {
+        int *key_ptr = static_cast<int *>(malloc(sizeof(int)));
+        *key_ptr = key;
+
+        bool present = std::find(unique.begin(), unique.end(), key) != unique.end();
+
+        int ret = bst_concurrent_insert(tree, key_ptr, key_ptr);
+        EXPECT_EQ(ret, present ? 0 : 1)
+            << "Concurrent tree rejects duplicate keys only.";
+
+        if (present)
+            free(key_ptr);
+        else
+            unique.push_back(key);
+    }
+
+    std::sort(unique.begin(), unique.end());
+
+    EXPECT_EQ(keys(reader), unique)
+        << "Concurrent tree iterates over keys in order.";
+
+    for (auto key : unique) {
+        void *data = nullptr;
+        ASSERT_TRUE(bst_reader_search(reader, &key, &data))
+            << "Concurrent tree contains " << key << ".";
+
+        EXPECT_EQ(*static_cast<int *>(data), key)
+            << "Concurrent tree has correct data for " << key << ".";
+    }
+
+    for (auto it = unique.begin(); it != unique.end(); ++it) {
+        ASSERT_TRUE(bst_concurrent_delete(tree, &*it, 1, 0))
+            << "Concurrent tree key deleted.";
+
+        EXPECT_FALSE(bst_concurrent_delete(tree, &*it, 1, 0))
+            << "Concurrent tree key can only be deleted once.";
+
+        EXPECT_EQ(keys(reader), std::vector<int>(it + 1, unique.end()))
+            << "Concurrent tree contains remaining keys.";
+    }
+
+    bst_reader_free(reader);
+    bst_concurrent_free(tree, 1, 0);
+}
+
+TEST(ConcurrentTreeStressTest, CanReadWhileWriting)
+{
+    enum { SIZE = 1 << 12, READERS = 4, ROUNDS = 20 };
+
+    auto tree = bst_concurrent_create(intcomp);
+    ASSERT_NE(tree, nullptr)
+        << "Concurrent tree created.";
+
+    /* even keys stay in the tree, odd keys are inserted and deleted */
+    for (int i = 0; i < SIZE; i += 2) {
+        int *key = static_cast<int *>(malloc(sizeof(int)));
+        *key = i;
+
+        bst_concurrent_insert(tree, key, nullptr);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < READERS; ++t) {
+        readers.emplace_back([&, t]() {
+            auto reader = bst_reader_create(tree);
+
+            while (!done) {
+                for (int i = 2 * t; i < SIZE; i += 2 * READERS) {
+                    if (!bst_reader_search(reader, &i, nullptr))
+                        ++errors;
+                }
+
+                /* even keys are seen in order while iterating */
+                bst_reader_lock(reader);
+
+                int expected = 0;
+                void *key = nullptr;
+
+                while (bst_reader_next(reader, key, &key, nullptr)) {
+                    int tmp = *static_cast<int *>(key);
+
+                    if (tmp % 2 == 0) {
+                        if (tmp != expected)
+                            ++errors;
+
+                        expected += 2;
+                    }
+                }
+
+                if (expected != SIZE)
+                    ++errors;
+
+                bst_reader_unlock(reader);
+            }
+
+            bst_reader_free(reader);
+        });
+    }
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 1; i < SIZE; i += 2) {
+            int *key = static_cast<int *>(malloc(sizeof(int)));
+            *key = i;
+
+            bst_concurrent_insert(tree, key, nullptr);
+        }
+
+        for (int i = 1; i < SIZE; i += 2)
+            bst_concurrent_delete(tree, &i, 1, 0);
+    }
+
+    done = true;
+
+    for (auto &reader : readers)
+        reader.join();
+
+    EXPECT_EQ(errors, 0)
+        << "Concurrent tree readers always see all permanent keys.";
+
+    bst_concurrent_free(tree, 1, 0);
+}
@@ -0,0 +1,400 @@
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "string_matching.h"
+
+/* Measures preprocessing time and scan throughput of every engine over a
+   range of text sizes, alphabets and pattern lengths. Texts are generated
+   from a fixed seed so that runs are comparable, the match counts of all
+   engines are cross checked. */
+
+static struct {
+    char const *name;
+    enum string_match_engine engine;
+} const engines[] = {
+    { "naive", STRING_MATCH_NAIVE },
+    { "rabin-karp", STRING_MATCH_RABIN_KARP },
+    { "dfa", STRING_MATCH_DFA },
+    { "kmp", STRING_MATCH_KMP },
+    { "boyer-moore", STRING_MATCH_BOYER_MOORE },
+    { "two-way", STRING_MATCH_TWO_WAY },
+    { "shift-or", STRING_MATCH_SHIFT_OR },
+    { "bndm", STRING_MATCH_BNDM },
+    { "auto", STRING_MATCH_AUTO }
+};
+
+#define N_ENGINES (sizeof(engines) / sizeof(engines[0]))
+
+/* workloads */
+
+enum workload_kind {
+    RANDOM_TEXT,   /* random text, pattern taken from the text */
+    PERIODIC_MISS, /* text a^n, pattern a^(m-1)b */
+    PERIODIC_LATE, /* text a^n, pattern a^(m-2)ba */
+    PERIODIC_HIT   /* text a^n, pattern a^m */
+};
+
+static struct {
+    char const *name;
+    enum workload_kind kind;
+    char const *alphabet; /* NULL for all bytes */
+} const workloads[] = {
+    { "dna", RANDOM_TEXT, "ACGT" },
+    /* roughly weighted by english letter frequency */
+    { "english", RANDOM_TEXT,
+      "                   eeeeeeeeeeeetttttttttaaaaaaaaoooooooiiiiiii"
+      "nnnnnnnsssssshhhhhhrrrrrrddddlllluuucccmmmwwffggyyppbbvkjxqz" },
+    { "bytes", RANDOM_TEXT, NULL },
+    { "aaa-ab", PERIODIC_MISS, NULL },
+    { "aaa-aba", PERIODIC_LATE, NULL },
+    { "aaa-aa", PERIODIC_HIT, NULL }
+};
+
+#define N_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+static size_t const comp_lens[] = { 4, 16, 64, 256 };
+
+#define N_COMP_LENS (sizeof(comp_lens) / sizeof(comp_lens[0]))
+
+#define MIN_TEXT_LEN ((size_t) 4 << 10)
+#define TEXT_LEN_STEP 16u
+
+/* every measurement is repeated until it took at least this long */
+#define MIN_SCAN_TIME 0.05
+#define MIN_COMPILE_TIME 0.01
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_next(uint64_t *rng)
+{
+    /* xorshift64* */
+    *rng ^= *rng >> 12;
+    *rng ^= *rng << 25;
+    *rng ^= *rng >> 27;
+
+    return *rng * 0x2545f4914f6cdd1du;
+}
+
+static void generate_text(char *text, size_t text_len, int workload)
+{
+    char const *alphabet = workloads[workload].alphabet;
+    uint64_t rng = 0x9e3779b97f4a7c15u;
+
+    switch (workloads[workload].kind) {
+    case RANDOM_TEXT: {
+        size_t sigma = alphabet ? strlen(alphabet) : 256u;
+
+        for (size_t i = 0; i < text_len; ++i) {
+            size_t c = rng_next(&rng) % sigma;
+            text[i] = alphabet ? alphabet[c] : (char) c;
+        }
+        break;
+    }
+    case PERIODIC_MISS:
+    case PERIODIC_LATE:
+    case PERIODIC_HIT:
+        memset(text, 'a', text_len);
+        break;
+    }
+}
+
+static void generate_comp(char *comp, size_t comp_len,
+                          char const *text, size_t text_len, int workload,
+                          uint64_t *rng)
+{
+    switch (workloads[workload].kind) {
+    case RANDOM_TEXT:
+        memcpy(comp, text + rng_next(rng) % (text_len - comp_len + 1u),
+               comp_len);
+        break;
+    case PERIODIC_MISS:
+        memset(comp, 'a', comp_len - 1u);
+        comp[comp_len - 1u] = 'b';
+        break;
+    case PERIODIC_LATE:
+        memset(comp, 'a', comp_len);
+        comp[comp_len - 2u] = 'b';
+        break;
+    case PERIODIC_HIT:
+        memset(comp, 'a', comp_len);
+        break;
+    }
+}
+
+/* measurements */
+
+struct result {
+    double compile_us;
+    double gb_per_s;
+    size_t matches;
+};
+
+static int measure(enum string_match_engine engine,
+                   char const *text, size_t text_len,
+                   char const *comp, size_t comp_len,
+                   unsigned reps, struct result *r)
+{
+    /* preprocessing, mean over enough compilations to be measurable */
+    size_t n_compiles = 0;
+    double start = now();
+    double elapsed;
+
+    do {
+        struct string_pattern *p =
+            string_pattern_compile_n(engine, comp, comp_len);
+        if (!p)
+            return 0;
+
+        string_pattern_free(p);
+
+        ++n_compiles;
+        elapsed = now() - start;
+    } while (elapsed < MIN_COMPILE_TIME);
+
+    r->compile_us = elapsed / n_compiles * 1e6;
+
+    /* scan, best of reps */
+    struct string_matcher *m =
+        string_matcher_create_n(engine, comp, comp_len);
+    if (!m)
+        return 0;
+
+    double best = 0.0;
+
+    for (unsigned rep = 0; rep < reps; ++rep) {
+        size_t n_scans = 0;
+        start = now();
+
+        do {
+            string_matcher_reset_n(m, text, text_len);
+            r->matches = string_matcher_count(m);
+
+            ++n_scans;
+            elapsed = now() - start;
+        } while (elapsed < MIN_SCAN_TIME);
+
+        double gb_per_s = (double) text_len * n_scans / elapsed * 1e-9;
+        if (gb_per_s > best)
+            best = gb_per_s;
+    }
+
+    r->gb_per_s = best;
+
+    string_matcher_free(m);
+
+    return 1;
+}
+
+/* command line */
+
+static void usage(char const *prog)
+{
+    fprintf(stderr, "usage: %s [-m SIZE] [-r REPS] [-e ENGINE]... "
+            "[-w WORKLOAD]...\n", prog);
+    fprintf(stderr, "  -m  maximum text size, may be suffixed with K, M or G "
+            "(default: 16M)\n");
+    fprintf(stderr, "  -r  repetitions per scan measurement, the best one is "
+            "reported (default: 3)\n");
+    fprintf(stderr, "  -e  only benchmark the given engines, any of:");
+    for (size_t i = 0; i < N_ENGINES; ++i)
+        fprintf(stderr, " %s", engines[i].name);
+    fprintf(stderr, "\n  -w  only benchmark the given workloads, any of:");
+    for (size_t i = 0; i < N_WORKLOADS; ++i)
+        fprintf(stderr, " %s", workloads[i].name);
+    fprintf(stderr, "\n");
+}
+
+static int parse_size(char const *str, size_t *size)
+{
+    char *end;
+    unsigned long long val = strtoull(str, &end, 10);
+
+    switch (*end) {
+    case 'G':
+        val <<= 10;
+        /* fall through */
+    case 'M':
+        val <<= 10;
+        /* fall through */
+    case 'K':
+        val <<= 10;
+        ++end;
+        break;
+    }
+
+    if (end == str || *end != '\0' || val == 0)
+        return 0;
+
+    *size = val;
+
+    return 1;
+}
+
+static int lookup_name(char const *name, char const *names[], size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (strcmp(name, names[i]) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_text_len = (size_t) 16 << 20;
+    unsigned reps = 3;
+    unsigned engine_mask = 0;
+    unsigned workload_mask = 0;
+
+    char const *engine_names[N_ENGINES];
+    for (size_t i = 0; i < N_ENGINES; ++i)
+        engine_names[i] = engines[i].name;
+
+    char const *workload_names[N_WORKLOADS];
+    for (size_t i = 0; i < N_WORKLOADS; ++i)
+        workload_names[i] = workloads[i].name;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:r:e:w:")) != -1) {
+        switch (opt) {
+        case 'm':
+            if (!parse_size(optarg, &max_text_len)) {
+                fprintf(stderr, "%s: invalid size '%s'\n", argv[0], optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'r':
+            reps = atoi(optarg);
+            if (reps == 0) {
+                fprintf(stderr, "%s: invalid repetitions '%s'\n",
+                        argv[0], optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'e': {
+            int i = lookup_name(optarg, engine_names, N_ENGINES);
+            if (i == -1) {
+                fprintf(stderr, "%s: unknown engine '%s'\n", argv[0], optarg);
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            engine_mask |= 1u << i;
+            break;
+        }
+        case 'w': {
+            int i = lookup_name(optarg, workload_names, N_WORKLOADS);
+            if (i == -1) {
+                fprintf(stderr, "%s: unknown workload '%s'\n",
+                        argv[0], optarg);
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            workload_mask |= 1u << i;
+            break;
+        }
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!engine_mask)
+        engine_mask = (1u << N_ENGINES) - 1u;
+    if (!workload_mask)
+        workload_mask = (1u << N_WORKLOADS) - 1u;
+
+    if (max_text_len < MIN_TEXT_LEN)
+        max_text_len = MIN_TEXT_LEN;
+
+    /* all text sizes of a workload are prefixes of the same text */
+    char *text = malloc(max_text_len);
+    if (!text) {
+        fprintf(stderr, "%s: failed to allocate text\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char comp[256];
+
+    printf("%-10s %12s %8s  %-12s %12s %10s %12s\n",
+           "workload", "text_len", "comp_len", "engine",
+           "compile_us", "GB/s", "matches");
+
+    int ret = EXIT_SUCCESS;
+
+    for (size_t w = 0; w < N_WORKLOADS; ++w) {
+        if (!(workload_mask & (1u << w)))
+            continue;
+
+        generate_text(text, max_text_len, w);
+
+        /* patterns only depend on workload and sizes */
+        uint64_t rng = 0x2545f4914f6cdd1du;
+
+        for (size_t text_len = MIN_TEXT_LEN; text_len <= max_text_len;
+             text_len *= TEXT_LEN_STEP) {
+            for (size_t l = 0; l < N_COMP_LENS; ++l) {
+                size_t comp_len = comp_lens[l];
+
+                generate_comp(comp, comp_len, text, text_len, w, &rng);
+
+                size_t expected = (size_t) -1;
+
+                for (size_t e = 0; e < N_ENGINES; ++e) {
+                    if (!(engine_mask & (1u << e)))
+                        continue;
+
+                    struct result r;
+                    if (!measure(engines[e].engine, text, text_len,
+                                 comp, comp_len, reps, &r)) {
+                        fprintf(stderr, "%s: %s failed to preprocess "
+                                "pattern\n", argv[0], engines[e].name);
+                        ret = EXIT_FAILURE;
+                        continue;
+                    }
+
+                    printf("%-10s %12zu %8zu  %-12s %12.3f %10.3f %12zu\n",
+                           workloads[w].name, text_len, comp_len,
+                           engines[e].name, r.compile_us, r.gb_per_s,
+                           r.matches);
+                    fflush(stdout);
+
+                    if (expected == (size_t) -1) {
+                        expected = r.matches;
+                    } else if (r.matches != expected) {
+                        fprintf(stderr, "%s: %s found %zu matches, "
+                                "expected %zu\n", argv[0], engines[e].name,
+                                r.matches, expected);
+                        ret = EXIT_FAILURE;
+                    }
+                }
+            }
+
+            if (text_len > max_text_len / TEXT_LEN_STEP)
+                break;
+        }
+    }
+
+    free(text);
+
+    return ret;
+}
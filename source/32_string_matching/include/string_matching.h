@@ -1,9 +1,270 @@
 #ifndef STRING_MATCHING_H
 #define STRING_MATCHING_H
 
+#include <stddef.h>
+
+
+/* static state matching (not reentrant), the _n variants take length
+   delimited texts and patterns which may contain NUL characters */
+
 size_t string_match_naive(char const *text, char const *comp);
 size_t string_match_rabin_karp(char const *text, char const *comp);
 size_t string_match_dfa(char const *text, char const *comp);
 size_t string_match_kmp(char const *text, char const *comp);
+size_t string_match_boyer_moore(char const *text, char const *comp);
+size_t string_match_two_way(char const *text, char const *comp);
+size_t string_match_shift_or(char const *text, char const *comp);
+size_t string_match_bndm(char const *text, char const *comp);
+
+size_t string_match_naive_n(char const *text, size_t text_len,
+                            char const *comp, size_t comp_len);
+size_t string_match_rabin_karp_n(char const *text, size_t text_len,
+                                 char const *comp, size_t comp_len);
+size_t string_match_dfa_n(char const *text, size_t text_len,
+                          char const *comp, size_t comp_len);
+size_t string_match_kmp_n(char const *text, size_t text_len,
+                          char const *comp, size_t comp_len);
+size_t string_match_boyer_moore_n(char const *text, size_t text_len,
+                                  char const *comp, size_t comp_len);
+size_t string_match_two_way_n(char const *text, size_t text_len,
+                              char const *comp, size_t comp_len);
+size_t string_match_shift_or_n(char const *text, size_t text_len,
+                               char const *comp, size_t comp_len);
+size_t string_match_bndm_n(char const *text, size_t text_len,
+                           char const *comp, size_t comp_len);
+
+/* same as above but selects the engine per text, see STRING_MATCH_AUTO */
+size_t string_match(char const *text, char const *comp);
+size_t string_match_n(char const *text, size_t text_len,
+                      char const *comp, size_t comp_len);
+
+
+/* compiled patterns, hold the preprocessed pattern of one engine and can be
+   shared by any number of matchers, also across threads, a pattern stays
+   alive until it has been freed and all matchers using it have been freed */
+
+enum string_match_engine {
+    STRING_MATCH_NAIVE,
+    STRING_MATCH_RABIN_KARP,
+    STRING_MATCH_DFA,
+    STRING_MATCH_KMP,
+    STRING_MATCH_BOYER_MOORE,
+    STRING_MATCH_TWO_WAY,
+    STRING_MATCH_SHIFT_OR,
+    STRING_MATCH_BNDM,
+
+    /* selects one of the above whenever a matcher is reset to a new text */
+    STRING_MATCH_AUTO
+};
+
+/* engine STRING_MATCH_AUTO selects for comp based on a sample of text, text
+   may be NULL in which case text_len is the expected text length or zero if
+   unknown */
+enum string_match_engine string_match_select(char const *text,
+                                             size_t text_len,
+                                             char const *comp,
+                                             size_t comp_len);
+
+struct string_pattern;
+
+struct string_pattern * string_pattern_compile(enum string_match_engine engine,
+                                               char const *comp);
+struct string_pattern * string_pattern_compile_n(
+    enum string_match_engine engine, char const *comp, size_t comp_len);
+void string_pattern_free(struct string_pattern *p);
+
+
+/* bounded LRU cache of compiled patterns keyed by engine and pattern bytes,
+   string_pattern_cache_get compiles patterns on a miss and returns a
+   reference that has to be released with string_pattern_free */
+
+struct string_pattern_cache;
+
+struct string_pattern_cache * string_pattern_cache_create(size_t capacity);
+void string_pattern_cache_free(struct string_pattern_cache *c);
+
+struct string_pattern * string_pattern_cache_get(
+    struct string_pattern_cache *c, enum string_match_engine engine,
+    char const *comp, size_t comp_len);
+
+
+/* reentrant matchers */
+
+struct string_matcher;
+
+struct string_matcher * string_matcher_create(enum string_match_engine engine,
+                                              char const *comp);
+struct string_matcher * string_matcher_create_n(
+    enum string_match_engine engine, char const *comp, size_t comp_len);
+struct string_matcher * string_matcher_create_from_pattern(
+    struct string_pattern *p);
+void string_matcher_free(struct string_matcher *m);
+
+size_t string_matcher_reset(struct string_matcher *m, char const *text);
+size_t string_matcher_reset_n(struct string_matcher *m,
+                              char const *text, size_t text_len);
+size_t string_matcher_next(struct string_matcher *m);
+
+/* store the offsets of up to max_matches next matches in matches and return
+   their number, the matcher resumes after the last returned match, so fewer
+   than max_matches results mean that the end of the text has been reached */
+size_t string_matcher_find_all(struct string_matcher *m,
+                               size_t *matches, size_t max_matches);
+
+/* number of remaining matches */
+size_t string_matcher_count(struct string_matcher *m);
+
+
+/* matcher statistics, only collected if the library has been built with
+   STRING_MATCH_STATS defined (make STATS=1), otherwise
+   string_matcher_get_stats zeroes stats and returns zero. Scan counters
+   accumulate over all texts since the matcher has been created, the
+   pattern properties are those of the engine the matcher currently uses. */
+
+struct string_matcher_stats {
+    /* scanning */
+    size_t chars_compared;  /* text characters compared to pattern
+                               characters or fed into an automaton */
+    size_t verifications;   /* windows compared to the pattern with memcmp */
+    size_t hash_hits;       /* Rabin-Karp windows hashing like the pattern */
+    size_t hash_collisions; /* hash hits that are no match */
+    size_t failure_links;   /* KMP failure links followed */
+    size_t matches;
+
+    /* preprocessing */
+    size_t compile_ns;      /* time spent compiling the pattern */
+    size_t table_bytes;     /* size of the compiled pattern */
+    size_t dfa_states;
+    size_t dfa_transitions; /* stored transitions */
+};
+
+int string_matcher_get_stats(struct string_matcher const *m,
+                             struct string_matcher_stats *stats);
+
+
+/* approximate matching, matchers report the start offsets of all windows of
+   text that differ from comp in at most k characters (Hamming distance),
+   patterns are limited to the number of bits in a size_t */
+
+struct string_pattern * string_pattern_compile_approx(char const *comp,
+                                                      size_t k);
+struct string_pattern * string_pattern_compile_approx_n(char const *comp,
+                                                        size_t comp_len,
+                                                        size_t k);
+
+struct string_matcher * string_matcher_create_approx(char const *comp,
+                                                     size_t k);
+struct string_matcher * string_matcher_create_approx_n(char const *comp,
+                                                       size_t comp_len,
+                                                       size_t k);
+
+
+/* reentrant multi pattern matchers, matches are reported in order of their
+   end offset, string_multi_matcher_next returns the start offset of the next
+   match and stores the index of the matching pattern in comp_id */
+
+enum string_multi_match_engine {
+    STRING_MULTI_MATCH_AHO_CORASICK,
+    STRING_MULTI_MATCH_RABIN_KARP
+};
+
+struct string_multi_matcher;
+
+struct string_multi_matcher * string_multi_matcher_create(
+    enum string_multi_match_engine engine, char const * const *comps,
+    size_t n_comps);
+struct string_multi_matcher * string_multi_matcher_create_n(
+    enum string_multi_match_engine engine, char const * const *comps,
+    size_t const *comp_lens, size_t n_comps);
+void string_multi_matcher_free(struct string_multi_matcher *m);
+
+size_t string_multi_matcher_reset(struct string_multi_matcher *m,
+                                  char const *text);
+size_t string_multi_matcher_reset_n(struct string_multi_matcher *m,
+                                    char const *text, size_t text_len);
+size_t string_multi_matcher_next(struct string_multi_matcher *m,
+                                 size_t *comp_id);
+
+
+/* streaming matchers (KMP, DFA and Rabin-Karp only), text is fed in chunks
+   which only need to stay valid until all matches ending in them have been
+   retrieved, offsets are relative to the start of the stream and
+   string_stream_matcher_next returns the current end of the stream once the
+   current chunk has been consumed */
+
+struct string_stream_matcher;
+
+struct string_stream_matcher * string_stream_matcher_create(
+    enum string_match_engine engine, char const *comp);
+struct string_stream_matcher * string_stream_matcher_create_n(
+    enum string_match_engine engine, char const *comp, size_t comp_len);
+void string_stream_matcher_free(struct string_stream_matcher *s);
+
+void string_stream_matcher_reset(struct string_stream_matcher *s);
+
+size_t string_stream_matcher_feed(struct string_stream_matcher *s,
+                                  char const *chunk, size_t chunk_len);
+size_t string_stream_matcher_next(struct string_stream_matcher *s);
+
+
+/* parallel matching, splits text into overlapping chunks that are searched
+   by n_threads threads (one per online processor if n_threads is zero) and
+   stores the offsets of all matches in ascending order in a newly allocated
+   array, returns the number of matches or (size_t) -1 on failure */
+
+size_t string_match_parallel(enum string_match_engine engine,
+                             char const *text, char const *comp,
+                             size_t n_threads, size_t **matches);
+size_t string_match_parallel_n(enum string_match_engine engine,
+                               char const *text, size_t text_len,
+                               char const *comp, size_t comp_len,
+                               size_t n_threads, size_t **matches);
+
+
+/* full text indexes, preprocess a fixed text once so that queries take time
+   depending on the pattern length and the number of matches but not on the
+   text length:
+
+   - the suffix array index keeps a copy of the text and its suffix array
+     (text_len * (1 + sizeof(size_t)) bytes), count and locate take
+     O(comp_len * log(text_len)) plus O(occ * log(occ)) to sort the matches
+   - the FM-index keeps the Burrows-Wheeler transform of the text with
+     sampled ranks and every STRING_INDEX_SAMPLE_RATE-th suffix array entry
+     (roughly 1.5 bytes per character for small alphabets), count takes
+     O(comp_len), locate additionally O(occ * STRING_INDEX_SAMPLE_RATE)
+
+   string_index_locate stores the offsets of all matches in ascending order
+   in a newly allocated array, returns the number of matches or (size_t) -1
+   on failure. Saved indexes use the byte order and word size of the host,
+   string_index_save returns nonzero on success. */
+
+#define STRING_INDEX_SAMPLE_RATE 32u
+
+enum string_index_type {
+    STRING_INDEX_SUFFIX_ARRAY,
+    STRING_INDEX_FM
+};
+
+struct string_index;
+
+struct string_index * string_index_create(enum string_index_type type,
+                                          char const *text);
+struct string_index * string_index_create_n(enum string_index_type type,
+                                            char const *text,
+                                            size_t text_len);
+void string_index_free(struct string_index *idx);
+
+size_t string_index_count(struct string_index const *idx, char const *comp);
+size_t string_index_count_n(struct string_index const *idx,
+                            char const *comp, size_t comp_len);
+
+size_t string_index_locate(struct string_index const *idx, char const *comp,
+                           size_t **matches);
+size_t string_index_locate_n(struct string_index const *idx,
+                             char const *comp, size_t comp_len,
+                             size_t **matches);
+
+int string_index_save(struct string_index const *idx, char const *path);
+struct string_index * string_index_load(char const *path);
 
 #endif
@@ -0,0 +1,255 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+/* Like the single pattern DFA the automaton is stored as a dense
+   (states x classes) table of row offsets over the byte classes of all
+   patterns, goto and failure transitions are merged into this table so that
+   the scan loop never follows failure links. The highest bit of a table entry
+   is set if the target state or any state on its failure chain is the end of
+   some pattern. */
+
+#define NONE ((size_t) -1)
+
+#define OUT_FLAG ((uint32_t) 1 << 31)
+#define ROW_MASK (OUT_FLAG - 1)
+
+struct aho_corasick {
+    size_t states;
+    size_t classes;
+
+    size_t *out;  /* first pattern ending in a state, NONE if there is none */
+    size_t *dict; /* next state on the failure chain that has an output */
+    size_t *same; /* next pattern with identical bytes */
+
+    uint16_t class_of[256];
+    uint32_t *table;
+};
+
+static void free_aho_corasick(void *pattern)
+{
+    struct aho_corasick *ac = pattern;
+
+    free(ac->out);
+    free(ac->dict);
+    free(ac->same);
+    free(ac->table);
+    free(ac);
+}
+
+static void build_trie(struct aho_corasick *ac, char const * const *comps,
+                       size_t const *comp_lens, size_t n_comps)
+{
+    size_t const classes = ac->classes;
+
+    /* insert in reverse so that identical patterns are reported in order */
+    for (size_t i = n_comps; i-- > 0;) {
+        if (comp_lens[i] == 0)
+            continue;
+
+        unsigned char const *comp = (unsigned char const *) comps[i];
+
+        uint32_t row = 0;
+        for (size_t j = 0; j < comp_lens[i]; ++j) {
+            uint32_t *next = ac->table + row + ac->class_of[comp[j]];
+            if (!*next)
+                *next = ac->states++ * classes;
+
+            row = *next;
+        }
+
+        size_t state = row / classes;
+        ac->same[i] = ac->out[state];
+        ac->out[state] = i;
+    }
+}
+
+static int build_failure(struct aho_corasick *ac)
+{
+    size_t const classes = ac->classes;
+
+    size_t *queue = malloc(ac->states * sizeof(size_t));
+    uint32_t *fail = malloc(ac->states * sizeof(uint32_t));
+    if (!queue || !fail) {
+        free(queue);
+        free(fail);
+        return 0;
+    }
+
+    /* breadth first, so the row of the failure state of any state is already
+       complete when the state itself is processed, entries of the row of the
+       current state that are still zero are missing goto transitions */
+    size_t head = 0, tail = 0;
+
+    queue[tail++] = 0;
+    fail[0] = 0;
+
+    while (head < tail) {
+        size_t state = queue[head++];
+        uint32_t *row = ac->table + state * classes;
+        uint32_t const *fail_row = ac->table + fail[state];
+
+        for (size_t a = 0; a < classes; ++a) {
+            if (!row[a]) {
+                if (state != 0)
+                    row[a] = fail_row[a];
+                continue;
+            }
+
+            size_t child = row[a] / classes;
+
+            fail[child] = state == 0 ? 0 : fail_row[a];
+
+            size_t fail_state = fail[child] / classes;
+            if (ac->out[fail_state] != NONE)
+                ac->dict[child] = fail_state;
+            else
+                ac->dict[child] = ac->dict[fail_state];
+
+            queue[tail++] = child;
+        }
+    }
+
+    free(queue);
+    free(fail);
+
+    /* flag all transitions into states that produce output */
+    size_t const entries = ac->states * classes;
+    for (size_t i = 0; i < entries; ++i) {
+        size_t target = ac->table[i] / classes;
+        if (ac->out[target] != NONE || ac->dict[target] != NONE)
+            ac->table[i] |= OUT_FLAG;
+    }
+
+    return 1;
+}
+
+static void * compile_aho_corasick(char const * const *comps,
+                                   size_t const *comp_lens, size_t n_comps)
+{
+    struct aho_corasick *ac = malloc(sizeof(struct aho_corasick));
+    if (!ac)
+        return NULL;
+
+    /* determine sigma, class 0 is reserved for characters not in patterns */
+    memset(ac->class_of, 0, sizeof(ac->class_of));
+
+    size_t classes = 1, max_states = 1;
+    for (size_t i = 0; i < n_comps; ++i) {
+        unsigned char const *comp = (unsigned char const *) comps[i];
+
+        for (size_t j = 0; j < comp_lens[i]; ++j) {
+            if (!ac->class_of[comp[j]])
+                ac->class_of[comp[j]] = classes++;
+        }
+
+        max_states += comp_lens[i];
+    }
+
+    ac->states = 1;
+    ac->classes = classes;
+    ac->out = NULL;
+    ac->dict = NULL;
+    ac->same = NULL;
+    ac->table = NULL;
+
+    if (max_states > ROW_MASK / classes) {
+        free_aho_corasick(ac);
+        return NULL;
+    }
+
+    ac->out = malloc(max_states * sizeof(size_t));
+    ac->dict = malloc(max_states * sizeof(size_t));
+    ac->same = malloc((n_comps ? n_comps : 1) * sizeof(size_t));
+    ac->table = calloc(max_states * classes, sizeof(uint32_t));
+
+    if (!ac->out || !ac->dict || !ac->same || !ac->table) {
+        free_aho_corasick(ac);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < max_states; ++i) {
+        ac->out[i] = NONE;
+        ac->dict[i] = NONE;
+    }
+
+    build_trie(ac, comps, comp_lens, n_comps);
+
+    if (!build_failure(ac)) {
+        free_aho_corasick(ac);
+        return NULL;
+    }
+
+    return ac;
+}
+
+static void aho_corasick_reset(struct string_multi_matcher *m)
+{
+    m->out_state = NONE;
+    m->out_id = NONE;
+}
+
+static size_t aho_corasick_next(struct string_multi_matcher *m,
+                                size_t *comp_id)
+{
+    struct aho_corasick const *ac = m->pattern;
+
+    unsigned char const *text = (unsigned char const *) m->text;
+    uint32_t const *table = ac->table;
+    uint16_t const *class_of = ac->class_of;
+
+    for (;;) {
+        /* report pending matches ending at the last examined offset */
+        if (m->out_id != NONE) {
+            size_t id = m->out_id;
+
+            m->out_id = ac->same[id];
+            if (m->out_id == NONE)
+                m->out_state = ac->dict[m->out_state];
+
+            if (comp_id)
+                *comp_id = id;
+
+            return m->offs - m->comp_lens[id];
+        }
+
+        if (m->out_state != NONE) {
+            m->out_id = ac->out[m->out_state];
+            continue;
+        }
+
+        /* scan until a state with output is entered */
+        size_t offs = m->offs;
+        size_t const end = m->text_len;
+        uint32_t row = m->state;
+        uint32_t entry = 0;
+
+        while (offs < end) {
+            entry = table[row + class_of[text[offs++]]];
+            row = entry & ROW_MASK;
+
+            if (entry & OUT_FLAG)
+                break;
+        }
+
+        m->offs = offs;
+        m->state = row;
+
+        if (!(entry & OUT_FLAG))
+            return m->text_len;
+
+        size_t state = row / ac->classes;
+        m->out_state = ac->out[state] != NONE ? state : ac->dict[state];
+    }
+}
+
+struct string_multi_matcher_ops const string_multi_match_aho_corasick_ops = {
+    .compile = compile_aho_corasick,
+    .free = free_aho_corasick,
+    .state_size = NULL,
+    .reset = aho_corasick_reset,
+    .next = aho_corasick_next
+};
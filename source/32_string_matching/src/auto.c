@@ -0,0 +1,352 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+/* Engine selection, thresholds are based on bench_string_matching runs on
+   x86-64 with AVX2:
+
+   - naive with its first/last character filter is the fastest engine on
+     all random texts (2 GB/s on DNA, 5 - 14 GB/s on english and random
+     bytes), but drops to 0.1 - 0.3 GB/s once most text positions pass the
+     filter as in a^n
+   - Shift-Or is the fastest engine on such texts (1 - 1.15 GB/s) as long
+     as the pattern fits into its automaton, otherwise KMP (0.5 - 1 GB/s),
+     the DFA stays at 0.4 GB/s and Boyer-Moore and BNDM degrade to
+     0.01 - 0.02 GB/s on a^n
+   - BNDM beats naive for long patterns over DNA (3.7 vs. 1.9 GB/s for 64
+     and 256 characters)
+   - Two-Way and Boyer-Moore only get close to or beat naive for long
+     patterns over large alphabets (13 - 20 GB/s vs. 14 GB/s for 256
+     characters of random bytes), Two-Way is preferred as it stays linear
+     if the sample was not representative
+
+   Rabin-Karp and the DFA never come out ahead for single patterns and are
+   not selected.
+
+   The sample can miss repetitive parts of the text, naive is therefore run
+   with a bound on its verification work and replaced by the linear time
+   engine that would have been selected for a^n once it exceeds it. */
+
+/* texts up to this length are searched with naive, the O(n * m) worst case
+   is cheaper than preprocessing there */
+#define SHORT_TEXT_LEN 64u
+
+/* the filter pass rate is estimated from up to SAMPLE_BLOCKS evenly spaced
+   blocks of the text */
+#define SAMPLE_BLOCKS 4u
+#define SAMPLE_BLOCK_LEN 512u
+
+#define WORD_BITS (sizeof(size_t) * CHAR_BIT)
+
+#define BNDM_MIN_COMP_LEN 64u
+#define BNDM_MAX_SIGMA 4u
+
+#define TWO_WAY_MIN_COMP_LEN 128u
+#define TWO_WAY_MIN_SIGMA 128u
+
+struct text_sample {
+    size_t len;
+    size_t first;    /* occurrences of the first pattern character */
+    size_t last;     /* occurrences of the last pattern character */
+    size_t distinct; /* distinct characters, only counted if requested */
+};
+
+static void sample_text(struct text_sample *s,
+                        unsigned char const *text, size_t text_len,
+                        unsigned char first, unsigned char last,
+                        int count_distinct)
+{
+    uint8_t seen[256] = {0};
+
+    size_t blocks = SAMPLE_BLOCKS;
+    size_t block_len = SAMPLE_BLOCK_LEN;
+
+    if (text_len <= blocks * block_len) {
+        blocks = 1u;
+        block_len = text_len;
+    }
+
+    s->len = blocks * block_len;
+    s->first = 0u;
+    s->last = 0u;
+    s->distinct = 0u;
+
+    for (size_t b = 0u; b < blocks; ++b) {
+        size_t start = blocks > 1u ?
+            b * ((text_len - block_len) / (blocks - 1u)) : 0u;
+        unsigned char const *block = text + start;
+
+        for (size_t i = 0u; i < block_len; ++i) {
+            s->first += block[i] == first;
+            s->last += block[i] == last;
+        }
+
+        if (count_distinct) {
+            for (size_t i = 0u; i < block_len; ++i)
+                seen[block[i]] = 1u;
+        }
+    }
+
+    if (count_distinct) {
+        for (size_t c = 0u; c < 256u; ++c)
+            s->distinct += seen[c];
+    }
+}
+
+enum string_match_engine string_match_select(char const *text,
+                                             size_t text_len,
+                                             char const *comp,
+                                             size_t comp_len)
+{
+    if (comp_len == 0u || (text_len > 0u && text_len < SHORT_TEXT_LEN))
+        return STRING_MATCH_NAIVE;
+
+    /* without a text the pattern is the best guess at its distribution */
+    if (!text) {
+        text = comp;
+        text_len = comp_len;
+    }
+
+    int long_comp = comp_len >= BNDM_MIN_COMP_LEN ||
+                    comp_len >= TWO_WAY_MIN_COMP_LEN;
+
+    struct text_sample s;
+    sample_text(&s, (unsigned char const *) text, text_len,
+                comp[0], comp[comp_len - 1u], long_comp);
+
+    /* more than half of all positions are expected to pass the filter */
+    if (2u * s.first * s.last > s.len * s.len)
+        return comp_len <= WORD_BITS ? STRING_MATCH_SHIFT_OR : STRING_MATCH_KMP;
+
+    if (comp_len >= BNDM_MIN_COMP_LEN && s.distinct <= BNDM_MAX_SIGMA)
+        return STRING_MATCH_BNDM;
+
+    if (comp_len >= TWO_WAY_MIN_COMP_LEN && s.distinct >= TWO_WAY_MIN_SIGMA)
+        return STRING_MATCH_TWO_WAY;
+
+    return STRING_MATCH_NAIVE;
+}
+
+
+/* automatic engine, holds the compiled patterns of all selectable engines
+   and switches the matcher to one of them whenever it is reset */
+
+struct auto_pattern {
+    /* NULL if the pattern length rules out the engine */
+    void *naive;
+    void *shift_or;
+    void *kmp;
+    void *bndm;
+    void *two_way;
+};
+
+static void auto_free(void *pattern)
+{
+    struct auto_pattern *p = pattern;
+
+    if (p->naive)
+        string_match_naive_ops.free(p->naive);
+    if (p->shift_or)
+        string_match_shift_or_ops.free(p->shift_or);
+    if (p->kmp)
+        string_match_kmp_ops.free(p->kmp);
+    if (p->bndm)
+        string_match_bndm_ops.free(p->bndm);
+    if (p->two_way)
+        string_match_two_way_ops.free(p->two_way);
+
+    free(p);
+}
+
+static void * auto_compile(char const *comp, size_t comp_len)
+{
+    struct auto_pattern *p = calloc(1u, sizeof(struct auto_pattern));
+    if (!p)
+        return NULL;
+
+    p->naive = string_match_naive_ops.compile(comp, comp_len);
+
+    if (comp_len <= WORD_BITS)
+        p->shift_or = string_match_shift_or_ops.compile(comp, comp_len);
+    else
+        p->kmp = string_match_kmp_ops.compile(comp, comp_len);
+
+    if (comp_len >= BNDM_MIN_COMP_LEN)
+        p->bndm = string_match_bndm_ops.compile(comp, comp_len);
+
+    if (comp_len >= TWO_WAY_MIN_COMP_LEN)
+        p->two_way = string_match_two_way_ops.compile(comp, comp_len);
+
+    if (!p->naive || (!p->shift_or && !p->kmp) ||
+        (comp_len >= BNDM_MIN_COMP_LEN && !p->bndm) ||
+        (comp_len >= TWO_WAY_MIN_COMP_LEN && !p->two_way)) {
+        auto_free(p);
+        return NULL;
+    }
+
+    return p;
+}
+
+static struct string_matcher_ops const auto_naive_ops;
+
+/* continue the scan from m->offs with the engine selected for a^n */
+static void auto_switch_to_linear(struct string_matcher *m)
+{
+    struct auto_pattern const *p = m->compiled->pattern;
+
+    if (p->shift_or) {
+        m->ops = &string_match_shift_or_ops;
+        m->pattern = p->shift_or;
+    } else {
+        m->ops = &string_match_kmp_ops;
+        m->pattern = p->kmp;
+    }
+
+    m->state = 0u;
+
+    if (m->ops->reset)
+        m->ops->reset(m);
+}
+
+static size_t auto_naive_next(struct string_matcher *m)
+{
+    size_t offs = string_match_naive_next_bounded(m);
+    if (offs != (size_t) -1)
+        return offs;
+
+    auto_switch_to_linear(m);
+
+    return m->ops->next(m);
+}
+
+static size_t auto_naive_find_all(struct string_matcher *m,
+                                  size_t *matches, size_t max_matches)
+{
+    size_t n = 0u;
+
+    while (n < max_matches) {
+        size_t offs = string_match_naive_next_bounded(m);
+
+        if (offs == (size_t) -1) {
+            auto_switch_to_linear(m);
+
+            return n + m->ops->find_all(m, matches + n, max_matches - n);
+        }
+
+        if (offs == m->text_len)
+            break;
+
+        matches[n++] = offs;
+    }
+
+    return n;
+}
+
+static void auto_reset(struct string_matcher *m)
+{
+    struct auto_pattern const *p = m->pattern;
+
+    switch (string_match_select(m->text, m->text_len, m->comp, m->comp_len)) {
+    case STRING_MATCH_SHIFT_OR:
+        m->ops = &string_match_shift_or_ops;
+        m->pattern = p->shift_or;
+        break;
+    case STRING_MATCH_KMP:
+        m->ops = &string_match_kmp_ops;
+        m->pattern = p->kmp;
+        break;
+    case STRING_MATCH_BNDM:
+        m->ops = &string_match_bndm_ops;
+        m->pattern = p->bndm;
+        break;
+    case STRING_MATCH_TWO_WAY:
+        m->ops = &string_match_two_way_ops;
+        m->pattern = p->two_way;
+        break;
+    default:
+        m->ops = &auto_naive_ops;
+        m->pattern = p->naive;
+        break;
+    }
+
+    if (m->ops->reset)
+        m->ops->reset(m);
+}
+
+/* before the first reset the tables of all engines are reported */
+static void auto_pattern_stats(void const *pattern, size_t comp_len,
+                               struct string_matcher_stats *stats)
+{
+    struct auto_pattern const *p = pattern;
+
+    struct {
+        struct string_matcher_ops const *ops;
+        void const *pattern;
+    } const engines[] = {
+        { &string_match_naive_ops, p->naive },
+        { &string_match_shift_or_ops, p->shift_or },
+        { &string_match_kmp_ops, p->kmp },
+        { &string_match_bndm_ops, p->bndm },
+        { &string_match_two_way_ops, p->two_way }
+    };
+
+    size_t table_bytes = sizeof(struct auto_pattern);
+
+    for (size_t i = 0u; i < sizeof(engines) / sizeof(engines[0]); ++i) {
+        if (engines[i].pattern) {
+            engines[i].ops->pattern_stats(engines[i].pattern, comp_len, stats);
+            table_bytes += stats->table_bytes;
+        }
+    }
+
+    stats->table_bytes = table_bytes;
+}
+
+static void auto_naive_pattern_stats(void const *pattern, size_t comp_len,
+                                     struct string_matcher_stats *stats)
+{
+    string_match_naive_ops.pattern_stats(pattern, comp_len, stats);
+}
+
+/* naive with bounded verification work, only installed by auto_reset */
+static struct string_matcher_ops const auto_naive_ops = {
+    .compile = NULL,
+    .free = NULL,
+    .state_size = NULL,
+    .reset = NULL,
+    .next = auto_naive_next,
+    .find_all = auto_naive_find_all,
+    .stream_next = NULL,
+    .pattern_stats = auto_naive_pattern_stats
+};
+
+/* next and find_all are never called, reset always switches the matcher to
+   the selected engine before a text is searched */
+struct string_matcher_ops const string_match_auto_ops = {
+    .compile = auto_compile,
+    .free = auto_free,
+    .state_size = NULL,
+    .reset = auto_reset,
+    .next = NULL,
+    .find_all = NULL,
+    .stream_next = NULL,
+    .pattern_stats = auto_pattern_stats
+};
+
+static struct string_match_static auto_static;
+
+size_t string_match(char const *text, char const *comp)
+{
+    return string_match_static(&auto_static, STRING_MATCH_AUTO, text, comp);
+}
+
+size_t string_match_n(char const *text, size_t text_len,
+                      char const *comp, size_t comp_len)
+{
+    return string_match_static_n(&auto_static, STRING_MATCH_AUTO,
+                                 text, text_len, comp, comp_len);
+}
@@ -0,0 +1,129 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+/* Backward Nondeterministic DAWG Matching, every window is read from right
+   to left with a bit parallel automaton recognizing all factors of the
+   pattern. Bit i of the state word is set if the characters read so far
+   occur in the pattern ending at position len - 1 - i. The window is
+   shifted to the longest pattern prefix seen, so typically only a few
+   characters per window are read. The automaton covers the first WORD_BITS
+   pattern characters, the remainder of longer patterns is compared once
+   the automaton has found a prefix. */
+
+#define WORD_BITS (sizeof(size_t) * CHAR_BIT)
+
+struct bndm_pattern {
+    size_t len; /* number of pattern characters in the automaton */
+    size_t masks[256];
+};
+
+static void * bndm_compile(char const *comp, size_t comp_len)
+{
+    struct bndm_pattern *p = malloc(sizeof(struct bndm_pattern));
+    if (!p)
+        return NULL;
+
+    p->len = comp_len < WORD_BITS ? comp_len : WORD_BITS;
+
+    for (size_t c = 0; c < 256; ++c)
+        p->masks[c] = 0;
+    for (size_t i = 0; i < p->len; ++i)
+        p->masks[(unsigned char) comp[i]] |= (size_t) 1 << (p->len - 1 - i);
+
+    return p;
+}
+
+static size_t bndm_find_all(struct string_matcher *m,
+                            size_t *matches, size_t max_matches)
+{
+    struct bndm_pattern const *p = m->pattern;
+
+    unsigned char const *text = (unsigned char const *) m->text;
+    size_t const *masks = p->masks;
+    size_t const len = p->len;
+    size_t const rest = m->comp_len - len;
+    size_t const prefix = (size_t) 1 << (len - 1);
+    size_t const last_shift = m->text_len - m->comp_len;
+
+    size_t pos = m->offs;
+    size_t n = 0;
+
+    while (pos <= last_shift && n < max_matches) {
+        size_t j = len;
+        size_t shift = len;
+        size_t state = ~(size_t) 0;
+
+        /* the state can only survive all len characters of the window with
+           the prefix bit set, so j does not drop below zero */
+        while (state) {
+            state &= masks[text[pos + j - 1]];
+            --j;
+
+            STATS_ADD(m, chars_compared, 1u);
+
+            if (state & prefix) {
+                if (j > 0) {
+                    shift = j;
+                } else {
+                    STATS_ADD(m, verifications, rest > 0);
+
+                    if (rest == 0 ||
+                        memcmp(text + pos + len, m->comp + len, rest) == 0) {
+                        matches[n++] = pos;
+                    }
+                    break;
+                }
+            }
+
+            state <<= 1;
+        }
+
+        pos += shift;
+    }
+
+    m->offs = pos;
+
+    return n;
+}
+
+static size_t bndm_next(struct string_matcher *m)
+{
+    size_t offs;
+
+    return bndm_find_all(m, &offs, 1) ? offs : m->text_len;
+}
+
+static void bndm_pattern_stats(void const *pattern, size_t comp_len,
+                               struct string_matcher_stats *stats)
+{
+    stats->table_bytes = sizeof(struct bndm_pattern);
+}
+
+struct string_matcher_ops const string_match_bndm_ops = {
+    .compile = bndm_compile,
+    .free = free,
+    .state_size = NULL,
+    .reset = NULL,
+    .next = bndm_next,
+    .find_all = bndm_find_all,
+    .stream_next = NULL,
+    .pattern_stats = bndm_pattern_stats
+};
+
+static struct string_match_static bndm_static;
+
+size_t string_match_bndm(char const *text, char const *comp)
+{
+    return string_match_static(&bndm_static, STRING_MATCH_BNDM, text, comp);
+}
+
+size_t string_match_bndm_n(char const *text, size_t text_len,
+                           char const *comp, size_t comp_len)
+{
+    return string_match_static_n(&bndm_static, STRING_MATCH_BNDM,
+                                 text, text_len, comp, comp_len);
+}
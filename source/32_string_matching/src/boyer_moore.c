@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+struct boyer_moore_pattern {
+    size_t bad_char[256];
+    size_t good_suffix[];
+};
+
+static void compute_bad_char(size_t *bad_char,
+                             unsigned char const *pattern, size_t pattern_len)
+{
+    for (size_t c = 0; c < 256; ++c)
+        bad_char[c] = pattern_len;
+
+    for (size_t i = 0; i < pattern_len - 1; ++i)
+        bad_char[pattern[i]] = pattern_len - 1 - i;
+}
+
+static void compute_suffixes(long *suff,
+                             unsigned char const *pattern, long pattern_len)
+{
+    /* suff[i] is the length of the longest substring of pattern ending at
+       position i that is also a suffix of pattern */
+
+    long f = 0;
+    long g = pattern_len - 1;
+
+    suff[pattern_len - 1] = pattern_len;
+
+    for (long i = pattern_len - 2; i >= 0; --i) {
+        if (i > g && suff[i + pattern_len - 1 - f] < i - g) {
+            suff[i] = suff[i + pattern_len - 1 - f];
+        } else {
+            if (i < g)
+                g = i;
+            f = i;
+            while (g >= 0 && pattern[g] == pattern[g + pattern_len - 1 - f])
+                --g;
+            suff[i] = f - g;
+        }
+    }
+}
+
+static void compute_good_suffix(size_t *good_suffix, long const *suff,
+                                long pattern_len)
+{
+    for (long i = 0; i < pattern_len; ++i)
+        good_suffix[i] = pattern_len;
+
+    /* the matched suffix only occurs as a prefix of the pattern */
+    long j = 0;
+    for (long i = pattern_len - 1; i >= -1; --i) {
+        if (i == -1 || suff[i] == i + 1) {
+            for (; j < pattern_len - 1 - i; ++j) {
+                if (good_suffix[j] == (size_t) pattern_len)
+                    good_suffix[j] = pattern_len - 1 - i;
+            }
+        }
+    }
+
+    /* the matched suffix reoccurs somewhere else in the pattern */
+    for (long i = 0; i <= pattern_len - 2; ++i)
+        good_suffix[pattern_len - 1 - suff[i]] = pattern_len - 1 - i;
+}
+
+static void * boyer_moore_compile(char const *comp, size_t comp_len)
+{
+    unsigned char const *pattern = (unsigned char const *) comp;
+
+    struct boyer_moore_pattern *p =
+        malloc(sizeof(struct boyer_moore_pattern) + comp_len * sizeof(size_t));
+    if (!p)
+        return NULL;
+
+    long *suff = malloc(comp_len * sizeof(long));
+    if (!suff) {
+        free(p);
+        return NULL;
+    }
+
+    compute_bad_char(p->bad_char, pattern, comp_len);
+    compute_suffixes(suff, pattern, comp_len);
+    compute_good_suffix(p->good_suffix, suff, comp_len);
+
+    free(suff);
+
+    return p;
+}
+
+static size_t boyer_moore_next(struct string_matcher *m)
+{
+    struct boyer_moore_pattern const *p = m->pattern;
+
+    unsigned char const *text = (unsigned char const *) m->text;
+    unsigned char const *pattern = (unsigned char const *) m->comp;
+    size_t const pattern_len = m->comp_len;
+    size_t const last_shift = m->text_len - pattern_len;
+
+    size_t shift = m->offs;
+
+    while (shift <= last_shift) {
+        size_t i = pattern_len;
+        while (i > 0 && pattern[i - 1] == text[shift + i - 1])
+            --i;
+
+        STATS_ADD(m, chars_compared, pattern_len - i + (i > 0));
+
+        if (i == 0) {
+            m->offs = shift + p->good_suffix[0];
+            return shift;
+        }
+
+        /* mismatch at pattern position i - 1 */
+        size_t gs = p->good_suffix[i - 1];
+        size_t bc = p->bad_char[text[shift + i - 1]];
+
+        if (bc + i > pattern_len && bc + i - pattern_len > gs)
+            shift += bc + i - pattern_len;
+        else
+            shift += gs;
+    }
+
+    m->offs = shift;
+
+    return m->text_len;
+}
+
+static void boyer_moore_pattern_stats(void const *pattern, size_t comp_len,
+                                      struct string_matcher_stats *stats)
+{
+    stats->table_bytes = sizeof(struct boyer_moore_pattern) +
+                         comp_len * sizeof(size_t);
+}
+
+struct string_matcher_ops const string_match_boyer_moore_ops = {
+    .compile = boyer_moore_compile,
+    .free = free,
+    .state_size = NULL,
+    .reset = NULL,
+    .next = boyer_moore_next,
+    .find_all = NULL,
+    .stream_next = NULL,
+    .pattern_stats = boyer_moore_pattern_stats
+};
+
+static struct string_match_static boyer_moore_static;
+
+size_t string_match_boyer_moore(char const *text, char const *comp)
+{
+    return string_match_static(&boyer_moore_static, STRING_MATCH_BOYER_MOORE,
+                               text, comp);
+}
+
+size_t string_match_boyer_moore_n(char const *text, size_t text_len,
+                                  char const *comp, size_t comp_len)
+{
+    return string_match_static_n(&boyer_moore_static, STRING_MATCH_BOYER_MOORE,
+                                 text, text_len, comp, comp_len);
+}
@@ -1,158 +1,154 @@
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "string_matching.h"
+#include "string_matcher_impl.h"
 
-#define HASHSIZE 10
-
-struct node {
-    char input;
-    size_t next_state;
-    struct node *next;
-};
+/* The transition function is stored as a dense (states x classes) table where
+   classes is the number of distinct pattern characters plus one class shared
+   by all characters not occurring in the pattern. Instead of state numbers the
+   table holds row offsets (state * classes) so that the scan loop does not
+   need to multiply. */
 
 struct transitions {
     size_t states;
-    struct node ***table;
+    size_t classes;
+    uint32_t accept; /* row offset of the accepting state */
+    uint16_t class_of[256];
+    uint32_t table[];
 };
 
-struct transitions * alloc_transitions(size_t states)
+static void * compute_transitions(char const *pattern, size_t pattern_len)
 {
-    struct transitions *ret = malloc(sizeof(struct transitions));
-    ret->states = states;
-    ret->table = malloc(states * sizeof(struct node **));
-    for (size_t i = 0; i < states; ++i) {
-        ret->table[i] = malloc(HASHSIZE * sizeof(struct node *));
-        for (size_t j = 0; j < HASHSIZE; ++j)
-            ret->table[i][j] = NULL;
+    uint16_t class_of[256] = {0};
+
+    /* determine sigma, class 0 is reserved for characters not in pattern */
+    size_t classes = 1;
+    for (size_t i = 0; i < pattern_len; ++i) {
+        unsigned char c = pattern[i];
+        if (!class_of[c])
+            class_of[c] = classes++;
     }
 
-    return ret;
-};
+    size_t states = pattern_len + 1;
+    if (states > UINT32_MAX / classes)
+        return NULL;
 
-static void add_transition(
-    struct transitions *delta, int state, char input, int next_state)
-{
-    struct node *tmp = malloc(sizeof(struct node));
-    tmp->input = input;
-    tmp->next_state = next_state;
-    tmp->next = delta->table[state][(unsigned char) input % HASHSIZE];
-    delta->table[state][(unsigned char) input % HASHSIZE] = tmp;
-}
+    struct transitions *delta =
+        malloc(sizeof(struct transitions) +
+               states * classes * sizeof(uint32_t));
+    if (!delta)
+        return NULL;
 
-static void free_transitions(struct transitions *delta)
-{
-    for (size_t i = 0; i < delta->states; ++i) {
-        for (size_t j = 0; j < HASHSIZE; ++j) {
-
-            struct node *list = delta->table[i][j];
-            while (list) {
-                struct node *tmp = list;
-                list = list->next;
-                free(tmp);
-            }
-        }
+    delta->states = states;
+    delta->classes = classes;
+    delta->accept = pattern_len * classes;
+    memcpy(delta->class_of, class_of, sizeof(class_of));
 
-        free(delta->table[i]);
-    }
+    /* compute delta in O(len(pattern) * len(sigma)), row x tracks the state
+       the automaton would be in after reading pattern[1..q), i.e. the state
+       given by the KMP failure function */
+    uint32_t *table = delta->table;
 
-    free(delta->table);
-    free(delta);
-}
+    for (size_t a = 0; a < classes; ++a)
+        table[a] = 0;
+    table[class_of[(unsigned char) pattern[0]]] = classes;
 
-static struct transitions * compute_transitions(
-    char const *pattern, size_t pattern_len)
-{
-    /* note that this function is cubic in len(pattern) und far from optimal */
+    size_t x = 0;
+    for (size_t q = 1; q <= pattern_len; ++q) {
+        uint32_t *row = table + q * classes;
 
-    static int charset[256];
-    static char sigma[256]; /* all distinct characters in input pattern */
+        memcpy(row, table + x, classes * sizeof(uint32_t));
 
-    /* determine sigma */
-    size_t n_sigma = 0;
-    for (size_t i = 0; i < pattern_len; ++i) {
-        char c = pattern[i];
-        if (!charset[(unsigned char) c]) {
-            sigma[n_sigma++] = c;
-            charset[(unsigned char) c] = 1;
+        if (q < pattern_len) {
+            uint16_t a = class_of[(unsigned char) pattern[q]];
+            row[a] = (q + 1) * classes;
+            x = table[x + a];
         }
     }
 
-    for (size_t s = 0; s < n_sigma; ++s)
-        charset[(unsigned char) sigma[s]] = 0;
-
-    /* compute delta */
-    struct transitions *delta = alloc_transitions(pattern_len + 1);
+    return delta;
+}
 
-    for (size_t q = 0; q <= pattern_len; ++q) {
-        for (size_t s = 0; s < n_sigma; ++s) {
-            size_t pref = pattern_len < q + 1 ? pattern_len : q + 1;
+static size_t dfa_find_all(struct string_matcher *m,
+                           size_t *matches, size_t max_matches)
+{
+    struct transitions const *delta = m->pattern;
 
-            do {
-                if (pattern[pref - 1] != sigma[s])
-                    continue;
+    unsigned char const *text = (unsigned char const *) m->text;
+    uint32_t const *table = delta->table;
+    uint16_t const *class_of = delta->class_of;
+    uint32_t const accept = delta->accept;
 
-                if (q == 0 ||
-                    strncmp(pattern, pattern + q + 1 - pref, pref - 1) == 0) {
+    size_t offs = m->offs;
+    size_t const end = m->text_len;
+    uint32_t row = m->state;
+    size_t n = 0;
 
-                    add_transition(delta, q, sigma[s], pref);
-                    break;
-                }
+    while (offs < end && n < max_matches) {
+        row = table[row + class_of[text[offs++]]];
 
-            } while (--pref > 0);
-        }
+        if (row == accept)
+            matches[n++] = offs - m->comp_len;
     }
 
-    return delta;
-}
+    STATS_ADD(m, chars_compared, offs - m->offs);
 
-size_t string_match_dfa(char const *text, char const *pattern)
-{
-    static int init = 0;
-
-    static size_t end_of_text = 0;
-    static size_t pattern_len = 0;
-    static size_t text_offs = 0;
+    m->offs = offs;
+    m->state = row;
 
-    static struct transitions *delta = NULL;
+    return n;
+}
 
-    if (!pattern) {
-        init = 1;
+static size_t dfa_next(struct string_matcher *m)
+{
+    size_t offs;
 
-        end_of_text = strlen(text);
-        return end_of_text;
-    }
+    return dfa_find_all(m, &offs, 1) ? offs : m->text_len;
+}
 
-    if (init) {
-        init = 0;
+static int dfa_stream_next(struct string_matcher *m)
+{
+    /* the start offset of a match that began in a previous chunk wraps
+       around but is not needed here */
+    size_t offs;
 
-        pattern_len = strlen(pattern);
-        text_offs = 0;
+    return dfa_find_all(m, &offs, 1) != 0;
+}
 
-        delta = compute_transitions(pattern, pattern_len);
-    }
+static void dfa_pattern_stats(void const *pattern, size_t comp_len,
+                              struct string_matcher_stats *stats)
+{
+    struct transitions const *delta = pattern;
 
-    size_t state = 0;
-    while (text_offs < end_of_text) {
-        char input = text[text_offs];
-        struct node *l = delta->table[state][(unsigned char) input % HASHSIZE];
-
-        state = 0;
-        while (l) {
-            if (l->input == input) {
-                state = l->next_state;
-                break;
-            }
-            l = l->next;
-        }
+    stats->table_bytes = sizeof(struct transitions) +
+                         delta->states * delta->classes * sizeof(uint32_t);
+    stats->dfa_states = delta->states;
+    stats->dfa_transitions = delta->states * delta->classes;
+}
 
-        if (state == pattern_len)
-            return text_offs + 1 - pattern_len;
+struct string_matcher_ops const string_match_dfa_ops = {
+    .compile = compute_transitions,
+    .free = free,
+    .state_size = NULL,
+    .reset = NULL,
+    .next = dfa_next,
+    .find_all = dfa_find_all,
+    .stream_next = dfa_stream_next,
+    .pattern_stats = dfa_pattern_stats
+};
 
-        ++text_offs;
-    }
+static struct string_match_static dfa_static;
 
-    free_transitions(delta);
+size_t string_match_dfa(char const *text, char const *pattern)
+{
+    return string_match_static(&dfa_static, STRING_MATCH_DFA, text, pattern);
+}
 
-    return end_of_text;
+size_t string_match_dfa_n(char const *text, size_t text_len,
+                          char const *pattern, size_t pattern_len)
+{
+    return string_match_static_n(&dfa_static, STRING_MATCH_DFA,
+                                 text, text_len, pattern, pattern_len);
 }
@@ -2,16 +2,19 @@
 #include <string.h>
 
 #include "string_matching.h"
+#include "string_matcher_impl.h"
 
-static size_t * compute_prefixes(char const *pattern, size_t pattern_len)
+static void * compute_prefixes(char const *pattern, size_t pattern_len)
 {
     size_t *prefixes = malloc(pattern_len * sizeof(size_t));
+    if (!prefixes)
+        return NULL;
 
     prefixes[0] = 0;
     size_t matching = 0;
     for (size_t state = 1; state < pattern_len; ++state) {
         while (matching > 0 && pattern[matching] != pattern[state])
-            matching = prefixes[matching];
+            matching = prefixes[matching - 1];
         if (pattern[matching] == pattern[state])
             ++matching;
         prefixes[state] = matching;
@@ -20,47 +23,87 @@ static size_t * compute_prefixes(char const *pattern, size_t pattern_len)
     return prefixes;
 }
 
-size_t string_match_kmp(char const *text, char const *pattern)
+static size_t kmp_find_all(struct string_matcher *m,
+                           size_t *matches, size_t max_matches)
 {
-    static int init = 0;
-
-    static size_t end_of_text = 0;
-    static size_t pattern_len = 0;
-    static size_t text_offs = 0;
-    static size_t state = 0;
-
-    static size_t *prefixes = NULL;
-
-    if (!pattern) {
-        init = 1;
+    char const *pattern = m->comp;
+    size_t const *prefixes = m->pattern;
 
-        end_of_text = strlen(text);
-        return end_of_text;
-    }
-
-    if (init) {
-        init = 0;
+    char const *text = m->text;
+    size_t const pattern_len = m->comp_len;
+    size_t const end = m->text_len;
 
-        pattern_len = strlen(pattern);
-        text_offs = 0;
+    size_t offs = m->offs;
+    size_t state = m->state;
+    size_t n = 0;
 
-        prefixes = compute_prefixes(pattern, pattern_len);
-
-        state = 0;
-    }
+    while (offs < end && n < max_matches) {
+        char c = text[offs++];
 
-    while (text_offs < end_of_text) {
-        while (state > 0 && pattern[state] != text[text_offs])
+        while (state > 0 && pattern[state] != c) {
+            STATS_ADD(m, failure_links, 1u);
+            STATS_ADD(m, chars_compared, 1u);
             state = prefixes[state - 1];
-        if (pattern[state] == text[text_offs])
+        }
+        if (pattern[state] == c)
             ++state;
         if (state == pattern_len) {
             state = prefixes[state - 1];
-            return ++text_offs - pattern_len;
+            matches[n++] = offs - pattern_len;
         }
-        ++text_offs;
     }
 
-    free(prefixes);
-    return end_of_text;
+    STATS_ADD(m, chars_compared, offs - m->offs);
+
+    m->offs = offs;
+    m->state = state;
+
+    return n;
+}
+
+static size_t kmp_next(struct string_matcher *m)
+{
+    size_t offs;
+
+    return kmp_find_all(m, &offs, 1) ? offs : m->text_len;
+}
+
+static int kmp_stream_next(struct string_matcher *m)
+{
+    /* the start offset of a match that began in a previous chunk wraps
+       around but is not needed here */
+    size_t offs;
+
+    return kmp_find_all(m, &offs, 1) != 0;
+}
+
+static void kmp_pattern_stats(void const *pattern, size_t comp_len,
+                              struct string_matcher_stats *stats)
+{
+    stats->table_bytes = comp_len * sizeof(size_t);
+}
+
+struct string_matcher_ops const string_match_kmp_ops = {
+    .compile = compute_prefixes,
+    .free = free,
+    .state_size = NULL,
+    .reset = NULL,
+    .next = kmp_next,
+    .find_all = kmp_find_all,
+    .stream_next = kmp_stream_next,
+    .pattern_stats = kmp_pattern_stats
+};
+
+static struct string_match_static kmp_static;
+
+size_t string_match_kmp(char const *text, char const *pattern)
+{
+    return string_match_static(&kmp_static, STRING_MATCH_KMP, text, pattern);
+}
+
+size_t string_match_kmp_n(char const *text, size_t text_len,
+                          char const *pattern, size_t pattern_len)
+{
+    return string_match_static_n(&kmp_static, STRING_MATCH_KMP,
+                                 text, text_len, pattern, pattern_len);
 }
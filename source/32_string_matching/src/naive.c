@@ -1,27 +1,293 @@
+#include <stdlib.h>
 #include <string.h>
 
 #include "string_matching.h"
+#include "string_matcher_impl.h"
 
-size_t string_match_naive(char const *text, char const *comp)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NAIVE_SIMD
+#include <immintrin.h>
+#endif
+
+/* bounded scans stop once the pattern characters compared while verifying
+   candidates, which are counted in m->state, exceed NAIVE_WORK_FACTOR times
+   the text offset plus NAIVE_WORK_SLACK */
+#define NAIVE_WORK_FACTOR 8u
+#define NAIVE_WORK_SLACK (64u * 1024u)
+
+/* candidates are verified in blocks of doubling size starting at this size,
+   so at most twice the characters up to the first mismatch plus this size
+   are counted */
+#define NAIVE_VERIFY_BLOCK 8u
+
+/* scan results besides match offsets */
+#define NAIVE_STOPPED ((size_t) -1)
+#define NAIVE_NONE ((size_t) -2)
+
+typedef size_t (*naive_scan_fn)(struct string_matcher *m,
+                                char const *text, size_t offs, size_t end,
+                                char const *comp, size_t comp_len,
+                                int bounded);
+
+struct naive_pattern {
+    naive_scan_fn scan;
+};
+
+
+/* verification */
+
+static int naive_verify(struct string_matcher *m,
+                        char const *text, char const *comp, size_t len)
+{
+    size_t block = NAIVE_VERIFY_BLOCK;
+
+    for (size_t i = 0; i < len; i += block, block *= 2) {
+        if (block > len - i)
+            block = len - i;
+
+        if (memcmp(text + i, comp + i, block) != 0) {
+            STATS_ADD(m, chars_compared, i + block);
+            m->state += i + block;
+            return 0;
+        }
+    }
+
+    STATS_ADD(m, chars_compared, len);
+    m->state += len;
+    return 1;
+}
+
+static int naive_exhausted(struct string_matcher const *m, size_t offs)
+{
+    return m->state > NAIVE_WORK_FACTOR * offs + NAIVE_WORK_SLACK;
+}
+
+
+/* scanning, all variants return the first match at an offset in [offs, end)
+   or end if there is none, end is the last offset at which comp still fits
+   into the text plus one, bounded scans may also return NAIVE_STOPPED in
+   which case m->offs is the first offset that has not been examined */
+
+static size_t naive_scan_scalar(struct string_matcher *m,
+                                char const *text, size_t offs, size_t end,
+                                char const *comp, size_t comp_len,
+                                int bounded)
+{
+    for (; offs < end; ++offs) {
+        STATS_ADD(m, chars_compared, 1u);
+
+        if (text[offs] != comp[0])
+            continue;
+
+        STATS_ADD(m, verifications, 1u);
+
+        if (naive_verify(m, text + offs + 1, comp + 1, comp_len - 1))
+            return offs;
+
+        if (bounded && naive_exhausted(m, offs)) {
+            m->offs = offs + 1;
+            return NAIVE_STOPPED;
+        }
+    }
+
+    return end;
+}
+
+#ifdef NAIVE_SIMD
+
+/* only positions at which both the first and the last pattern character
+   match are compared in full, these are determined for 16 (SSE2) or 32
+   (AVX2) consecutive positions at once */
+
+static inline size_t naive_candidates(struct string_matcher *m,
+                                      char const *text, size_t offs,
+                                      unsigned mask,
+                                      char const *comp, size_t comp_len,
+                                      int bounded)
+{
+    while (mask) {
+        size_t i = offs + __builtin_ctz(mask);
+
+        STATS_ADD(m, verifications, comp_len > 2);
+
+        if (comp_len <= 2 ||
+            naive_verify(m, text + i + 1, comp + 1, comp_len - 2)) {
+            return i;
+        }
+
+        if (bounded && naive_exhausted(m, i)) {
+            m->offs = i + 1;
+            return NAIVE_STOPPED;
+        }
+
+        mask &= mask - 1;
+    }
+
+    return NAIVE_NONE;
+}
+
+__attribute__((target("sse2")))
+static size_t naive_scan_sse2(struct string_matcher *m,
+                              char const *text, size_t offs, size_t end,
+                              char const *comp, size_t comp_len,
+                              int bounded)
+{
+    __m128i const first = _mm_set1_epi8(comp[0]);
+    __m128i const last = _mm_set1_epi8(comp[comp_len - 1]);
+
+    for (; offs + 16 <= end; offs += 16) {
+        __m128i block_first =
+            _mm_loadu_si128((__m128i const *) (text + offs));
+        __m128i block_last =
+            _mm_loadu_si128((__m128i const *) (text + offs + comp_len - 1));
+
+        unsigned mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                          _mm_cmpeq_epi8(last, block_last)));
+
+        STATS_ADD(m, chars_compared, 32u);
+
+        size_t i = naive_candidates(m, text, offs, mask, comp, comp_len,
+                                    bounded);
+        if (i != NAIVE_NONE)
+            return i;
+    }
+
+    return naive_scan_scalar(m, text, offs, end, comp, comp_len, bounded);
+}
+
+__attribute__((target("avx2")))
+static size_t naive_scan_avx2(struct string_matcher *m,
+                              char const *text, size_t offs, size_t end,
+                              char const *comp, size_t comp_len,
+                              int bounded)
+{
+    __m256i const first = _mm256_set1_epi8(comp[0]);
+    __m256i const last = _mm256_set1_epi8(comp[comp_len - 1]);
+
+    for (; offs + 32 <= end; offs += 32) {
+        __m256i block_first =
+            _mm256_loadu_si256((__m256i const *) (text + offs));
+        __m256i block_last =
+            _mm256_loadu_si256((__m256i const *) (text + offs + comp_len - 1));
+
+        unsigned mask = (unsigned) _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                             _mm256_cmpeq_epi8(last, block_last)));
+
+        STATS_ADD(m, chars_compared, 64u);
+
+        size_t i = naive_candidates(m, text, offs, mask, comp, comp_len,
+                                    bounded);
+        if (i != NAIVE_NONE)
+            return i;
+    }
+
+    return naive_scan_sse2(m, text, offs, end, comp, comp_len, bounded);
+}
+
+#endif
+
+static void * naive_compile(char const *comp, size_t comp_len)
+{
+    struct naive_pattern *p = malloc(sizeof(struct naive_pattern));
+    if (!p)
+        return NULL;
+
+    p->scan = naive_scan_scalar;
+
+#ifdef NAIVE_SIMD
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        p->scan = naive_scan_avx2;
+    else if (__builtin_cpu_supports("sse2"))
+        p->scan = naive_scan_sse2;
+#endif
+
+    return p;
+}
+
+static size_t naive_next_impl(struct string_matcher *m, int bounded)
 {
-    static size_t curr_offs = 0u;
-    static size_t end_of_text = 0u;
+    struct naive_pattern const *p = m->pattern;
+
+    size_t end = m->text_len - m->comp_len + 1;
 
-    if (!comp) {
-        curr_offs = 0u;
-        end_of_text = strlen(text);
-        return end_of_text;
+    size_t ret = p->scan(m, m->text, m->offs, end, m->comp, m->comp_len,
+                         bounded);
+    if (ret == NAIVE_STOPPED)
+        return ret;
+
+    if (ret == end) {
+        m->offs = end;
+        return m->text_len;
     }
 
-    size_t comp_len = strlen(comp);
-    while (curr_offs + comp_len <= end_of_text) {
-        if (strncmp(text + curr_offs, comp, comp_len) == 0) {
-            size_t ret = curr_offs++;
-            return ret;
+    m->offs = ret + 1;
+    return ret;
+}
+
+static size_t naive_next(struct string_matcher *m)
+{
+    return naive_next_impl(m, 0);
+}
+
+size_t string_match_naive_next_bounded(struct string_matcher *m)
+{
+    return naive_next_impl(m, 1);
+}
+
+static size_t naive_find_all(struct string_matcher *m,
+                             size_t *matches, size_t max_matches)
+{
+    struct naive_pattern const *p = m->pattern;
+
+    size_t end = m->text_len - m->comp_len + 1;
+    size_t n = 0;
+
+    while (n < max_matches) {
+        size_t ret = p->scan(m, m->text, m->offs, end, m->comp, m->comp_len,
+                             0);
+        if (ret == end) {
+            m->offs = end;
+            break;
         }
 
-        ++curr_offs;
+        matches[n++] = ret;
+        m->offs = ret + 1;
     }
 
-    return end_of_text;
+    return n;
+}
+
+static void naive_pattern_stats(void const *pattern, size_t comp_len,
+                                struct string_matcher_stats *stats)
+{
+    stats->table_bytes = sizeof(struct naive_pattern);
+}
+
+struct string_matcher_ops const string_match_naive_ops = {
+    .compile = naive_compile,
+    .free = free,
+    .state_size = NULL,
+    .reset = NULL,
+    .next = naive_next,
+    .find_all = naive_find_all,
+    .stream_next = NULL,
+    .pattern_stats = naive_pattern_stats
+};
+
+static struct string_match_static naive_static;
+
+size_t string_match_naive(char const *text, char const *comp)
+{
+    return string_match_static(&naive_static, STRING_MATCH_NAIVE, text, comp);
+}
+
+size_t string_match_naive_n(char const *text, size_t text_len,
+                            char const *comp, size_t comp_len)
+{
+    return string_match_static_n(&naive_static, STRING_MATCH_NAIVE,
+                                 text, text_len, comp, comp_len);
 }
@@ -0,0 +1,210 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+#define MIN_CHUNK_SIZE (64u * 1024u)
+#define CHUNKS_PER_THREAD 4u
+
+struct chunk {
+    size_t *matches;
+    size_t n_matches;
+    size_t capacity;
+};
+
+struct parallel_search {
+    struct string_pattern *pattern;
+
+    char const *text;
+    size_t text_len;
+    size_t comp_len;
+
+    size_t chunk_size;
+    size_t n_chunks;
+    struct chunk *chunks;
+
+    size_t next_chunk; /* accessed atomically */
+    int failed;        /* accessed atomically */
+};
+
+static int chunk_grow(struct chunk *c)
+{
+    size_t capacity = c->capacity ? 2u * c->capacity : 16u;
+
+    size_t *tmp = realloc(c->matches, capacity * sizeof(size_t));
+    if (!tmp)
+        return 0;
+
+    c->matches = tmp;
+    c->capacity = capacity;
+
+    return 1;
+}
+
+static void * search_chunks(void *arg)
+{
+    struct parallel_search *s = arg;
+
+    struct string_matcher *m = string_matcher_create_from_pattern(s->pattern);
+    if (!m) {
+        __atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    size_t const last_start = s->text_len - s->comp_len;
+
+    for (;;) {
+        size_t i = __atomic_fetch_add(&s->next_chunk, 1u, __ATOMIC_RELAXED);
+        if (i >= s->n_chunks || __atomic_load_n(&s->failed, __ATOMIC_RELAXED))
+            break;
+
+        /* chunk i owns all matches starting in [start, end), it is extended
+           by len(comp) - 1 characters so that these can be found */
+        size_t start = i * s->chunk_size;
+        size_t end = start + s->chunk_size;
+        if (end > last_start + 1u)
+            end = last_start + 1u;
+
+        size_t chunk_len = end - start + s->comp_len - 1u;
+        string_matcher_reset_n(m, s->text + start, chunk_len);
+
+        struct chunk *c = &s->chunks[i];
+
+        for (;;) {
+            if (c->n_matches == c->capacity && !chunk_grow(c)) {
+                __atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+                break;
+            }
+
+            size_t max_matches = c->capacity - c->n_matches;
+            size_t n = string_matcher_find_all(m, c->matches + c->n_matches,
+                                               max_matches);
+
+            /* offsets are relative to the chunk */
+            for (size_t j = c->n_matches; j < c->n_matches + n; ++j)
+                c->matches[j] += start;
+
+            c->n_matches += n;
+
+            if (n < max_matches)
+                break;
+        }
+    }
+
+    string_matcher_free(m);
+
+    return NULL;
+}
+
+size_t string_match_parallel(enum string_match_engine engine,
+                             char const *text, char const *comp,
+                             size_t n_threads, size_t **matches)
+{
+    return string_match_parallel_n(engine, text, strlen(text),
+                                   comp, strlen(comp), n_threads, matches);
+}
+
+size_t string_match_parallel_n(enum string_match_engine engine,
+                               char const *text, size_t text_len,
+                               char const *comp, size_t comp_len,
+                               size_t n_threads, size_t **matches)
+{
+    *matches = NULL;
+
+    struct parallel_search s;
+    s.text = text;
+    s.text_len = text_len;
+    s.comp_len = comp_len;
+    s.next_chunk = 0u;
+    s.failed = 0;
+
+    if (s.comp_len == 0u || s.comp_len > s.text_len)
+        return 0u;
+
+    /* all threads share one compiled pattern */
+    s.pattern = string_pattern_compile_n(engine, comp, comp_len);
+    if (!s.pattern)
+        return (size_t) -1;
+
+    if (n_threads == 0u) {
+        long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = n_cpus > 0 ? (size_t) n_cpus : 1u;
+    }
+
+    /* split the possible match start offsets into chunks */
+    size_t n_starts = s.text_len - s.comp_len + 1u;
+
+    s.chunk_size = n_starts / (n_threads * CHUNKS_PER_THREAD);
+    if (s.chunk_size < MIN_CHUNK_SIZE)
+        s.chunk_size = MIN_CHUNK_SIZE;
+    if (s.chunk_size < s.comp_len)
+        s.chunk_size = s.comp_len;
+
+    s.n_chunks = (n_starts + s.chunk_size - 1u) / s.chunk_size;
+    if (n_threads > s.n_chunks)
+        n_threads = s.n_chunks;
+
+    s.chunks = calloc(s.n_chunks, sizeof(struct chunk));
+    if (!s.chunks) {
+        string_pattern_free(s.pattern);
+        return (size_t) -1;
+    }
+
+    /* search, the calling thread acts as one of the workers */
+    pthread_t *threads = NULL;
+    if (n_threads > 1u) {
+        threads = malloc((n_threads - 1u) * sizeof(pthread_t));
+        if (!threads) {
+            string_pattern_free(s.pattern);
+            free(s.chunks);
+            return (size_t) -1;
+        }
+    }
+
+    size_t n_started = 0u;
+    for (; n_started < n_threads - 1u; ++n_started) {
+        if (pthread_create(&threads[n_started], NULL, search_chunks, &s) != 0)
+            break;
+    }
+
+    search_chunks(&s);
+
+    for (size_t t = 0u; t < n_started; ++t)
+        pthread_join(threads[t], NULL);
+
+    free(threads);
+
+    string_pattern_free(s.pattern);
+
+    /* merge, chunks are disjoint and ordered so concatenating them yields
+       ordered offsets without duplicates */
+    size_t n_matches = 0u;
+    for (size_t i = 0u; i < s.n_chunks; ++i)
+        n_matches += s.chunks[i].n_matches;
+
+    if (!s.failed && n_matches > 0u) {
+        *matches = malloc(n_matches * sizeof(size_t));
+        if (*matches) {
+            size_t *dst = *matches;
+            for (size_t i = 0u; i < s.n_chunks; ++i) {
+                memcpy(dst, s.chunks[i].matches,
+                       s.chunks[i].n_matches * sizeof(size_t));
+                dst += s.chunks[i].n_matches;
+            }
+        } else {
+            s.failed = 1;
+        }
+    }
+
+    for (size_t i = 0u; i < s.n_chunks; ++i)
+        free(s.chunks[i].matches);
+
+    free(s.chunks);
+
+    return s.failed ? (size_t) -1 : n_matches;
+}
@@ -0,0 +1,222 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+/* Entries are kept in a doubly linked list in order of last use and in a
+   chained hash table keyed by engine and pattern bytes. */
+
+struct cache_entry {
+    struct string_pattern *p;
+    uint64_t key;
+
+    struct cache_entry *prev, *next; /* use order, most recent first */
+    struct cache_entry *chain;
+};
+
+struct string_pattern_cache {
+    pthread_mutex_t lock;
+
+    size_t capacity;
+    size_t size;
+
+    struct cache_entry *first, *last;
+
+    size_t mask;
+    struct cache_entry **buckets;
+};
+
+static uint64_t cache_key(enum string_match_engine engine,
+                          char const *comp, size_t comp_len)
+{
+    /* FNV-1a */
+    uint64_t key = 0xcbf29ce484222325u ^ (uint64_t) engine;
+
+    for (size_t i = 0u; i < comp_len; ++i) {
+        key ^= (unsigned char) comp[i];
+        key *= 0x100000001b3u;
+    }
+
+    return key;
+}
+
+static void list_unlink(struct string_pattern_cache *c, struct cache_entry *e)
+{
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        c->first = e->next;
+
+    if (e->next)
+        e->next->prev = e->prev;
+    else
+        c->last = e->prev;
+}
+
+static void list_push_front(struct string_pattern_cache *c,
+                            struct cache_entry *e)
+{
+    e->prev = NULL;
+    e->next = c->first;
+
+    if (c->first)
+        c->first->prev = e;
+    else
+        c->last = e;
+
+    c->first = e;
+}
+
+static struct cache_entry * cache_lookup(struct string_pattern_cache *c,
+                                         uint64_t key,
+                                         enum string_match_engine engine,
+                                         char const *comp, size_t comp_len)
+{
+    struct cache_entry *e = c->buckets[key & c->mask];
+
+    while (e) {
+        struct string_pattern const *p = e->p;
+
+        if (e->key == key && p->engine == engine && p->comp_len == comp_len &&
+            memcmp(p->comp, comp, comp_len) == 0) {
+            return e;
+        }
+
+        e = e->chain;
+    }
+
+    return NULL;
+}
+
+static void cache_evict(struct string_pattern_cache *c)
+{
+    struct cache_entry *e = c->last;
+
+    list_unlink(c, e);
+
+    struct cache_entry **link = &c->buckets[e->key & c->mask];
+    while (*link != e)
+        link = &(*link)->chain;
+    *link = e->chain;
+
+    --c->size;
+
+    string_pattern_free(e->p);
+    free(e);
+}
+
+struct string_pattern_cache * string_pattern_cache_create(size_t capacity)
+{
+    if (capacity == 0u)
+        return NULL;
+
+    struct string_pattern_cache *c =
+        malloc(sizeof(struct string_pattern_cache));
+    if (!c)
+        return NULL;
+
+    size_t buckets = 1u;
+    while (buckets < capacity)
+        buckets <<= 1;
+
+    c->buckets = calloc(buckets, sizeof(struct cache_entry *));
+    if (!c->buckets) {
+        free(c);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&c->lock, NULL) != 0) {
+        free(c->buckets);
+        free(c);
+        return NULL;
+    }
+
+    c->capacity = capacity;
+    c->size = 0u;
+    c->first = NULL;
+    c->last = NULL;
+    c->mask = buckets - 1u;
+
+    return c;
+}
+
+void string_pattern_cache_free(struct string_pattern_cache *c)
+{
+    if (!c)
+        return;
+
+    while (c->size > 0u)
+        cache_evict(c);
+
+    pthread_mutex_destroy(&c->lock);
+
+    free(c->buckets);
+    free(c);
+}
+
+struct string_pattern * string_pattern_cache_get(
+    struct string_pattern_cache *c, enum string_match_engine engine,
+    char const *comp, size_t comp_len)
+{
+    uint64_t key = cache_key(engine, comp, comp_len);
+
+    pthread_mutex_lock(&c->lock);
+
+    struct cache_entry *e = cache_lookup(c, key, engine, comp, comp_len);
+    if (e) {
+        list_unlink(c, e);
+        list_push_front(c, e);
+
+        struct string_pattern *p = string_pattern_ref(e->p);
+
+        pthread_mutex_unlock(&c->lock);
+
+        return p;
+    }
+
+    pthread_mutex_unlock(&c->lock);
+
+    /* compile without holding the lock, another thread might insert the same
+       pattern in the meantime in which case the new one is discarded */
+    struct string_pattern *p = string_pattern_compile_n(engine, comp, comp_len);
+    if (!p)
+        return NULL;
+
+    e = malloc(sizeof(struct cache_entry));
+    if (!e)
+        return p;
+
+    pthread_mutex_lock(&c->lock);
+
+    struct cache_entry *other = cache_lookup(c, key, engine, comp, comp_len);
+    if (other) {
+        list_unlink(c, other);
+        list_push_front(c, other);
+
+        struct string_pattern *tmp = string_pattern_ref(other->p);
+
+        pthread_mutex_unlock(&c->lock);
+
+        string_pattern_free(p);
+        free(e);
+
+        return tmp;
+    }
+
+    if (c->size == c->capacity)
+        cache_evict(c);
+
+    e->p = string_pattern_ref(p);
+    e->key = key;
+    e->chain = c->buckets[key & c->mask];
+    c->buckets[key & c->mask] = e;
+    list_push_front(c, e);
+    ++c->size;
+
+    pthread_mutex_unlock(&c->lock);
+
+    return p;
+}
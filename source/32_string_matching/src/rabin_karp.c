@@ -1,67 +1,428 @@
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "string_matching.h"
+#include "string_matcher_impl.h"
 
-/* a prime such that 256*Q is significantly smaller than the least possible
-   maximum values a long can take on. */
-#define Q 251
+/* Windows are hashed as polynomials in BASE modulo the Mersenne prime
+   2^61 - 1, the probability of two different windows colliding is around
+   len(comp) / 2^61. Characters are hashed as unsigned values. */
 
-size_t string_match_rabin_karp(char const *text, char const *comp)
+#define P (((uint64_t) 1 << 61) - 1)
+#define BASE ((uint64_t) 0x1f3d5b79a3c5e7u)
+
+#define NONE ((size_t) -1)
+
+static inline uint64_t mod_mul(uint64_t a, uint64_t b)
 {
-    static int init = 0;
+    __extension__ unsigned __int128 prod = (unsigned __int128) a * b;
 
-    static size_t end_of_text = 0u;
-    static size_t comp_len = 0u;
-    static size_t shift = 0u;
+    uint64_t ret = (uint64_t) (prod & P) + (uint64_t) (prod >> 61);
+
+    return ret >= P ? ret - P : ret;
+}
+
+static inline uint64_t hash_push(uint64_t hash, unsigned char in)
+{
+    hash = mod_mul(hash, BASE) + in;
+
+    return hash >= P ? hash - P : hash;
+}
 
-    static long msd = 1;
-    static long text_val = 0;
-    static long comp_val = 0;
+static inline uint64_t hash_roll(uint64_t hash, uint64_t msd,
+                                 unsigned char out, unsigned char in)
+{
+    uint64_t tmp = mod_mul(out, msd);
+
+    hash = hash >= tmp ? hash - tmp : hash + P - tmp;
+
+    return hash_push(hash, in);
+}
+
+static uint64_t hash_string(char const *str, size_t len)
+{
+    uint64_t hash = 0;
+    for (size_t i = 0u; i < len; ++i)
+        hash = hash_push(hash, str[i]);
+
+    return hash;
+}
 
-    if (!comp) {
-        init = 1;
+static uint64_t hash_msd(size_t len)
+{
+    /* BASE^(len - 1) */
+    uint64_t msd = 1;
+    for (size_t i = 1u; i < len; ++i)
+        msd = mod_mul(msd, BASE);
+
+    return msd;
+}
+
+
+/* single pattern */
+
+struct rabin_karp_pattern {
+    uint64_t msd;
+    uint64_t comp_val;
+};
+
+static void * rabin_karp_compile(char const *comp, size_t comp_len)
+{
+    struct rabin_karp_pattern *p = malloc(sizeof(struct rabin_karp_pattern));
+    if (!p)
+        return NULL;
+
+    p->msd = hash_msd(comp_len);
+    p->comp_val = hash_string(comp, comp_len);
+
+    return p;
+}
+
+static void rabin_karp_reset(struct string_matcher *m)
+{
+    /* hash of the first window minus its last character, so that every step
+       of the scan loop can roll in exactly one character */
+    m->hash = hash_string(m->text, m->comp_len - 1u);
+}
+
+static size_t rabin_karp_find_all(struct string_matcher *m,
+                                  size_t *matches, size_t max_matches)
+{
+    struct rabin_karp_pattern const *p = m->pattern;
 
-        end_of_text = strlen(text);
-        return end_of_text;
+    unsigned char const *text = (unsigned char const *) m->text;
+    size_t const comp_len = m->comp_len;
+    size_t const end = m->text_len;
+
+    /* m->offs is the start of the next window and m->hash the hash of the
+       previous one, or of all but the last character of the first window */
+    size_t offs = m->offs;
+    uint64_t hash = m->hash;
+    size_t n = 0;
+
+    while (offs + comp_len <= end && n < max_matches) {
+        if (offs == 0u)
+            hash = hash_push(hash, text[comp_len - 1u]);
+        else
+            hash = hash_roll(hash, p->msd, text[offs - 1u],
+                             text[offs + comp_len - 1u]);
+
+        if (hash == p->comp_val) {
+            STATS_ADD(m, hash_hits, 1u);
+            STATS_ADD(m, verifications, 1u);
+
+            if (memcmp(text + offs, m->comp, comp_len) == 0)
+                matches[n++] = offs;
+            else
+                STATS_ADD(m, hash_collisions, 1u);
+        }
+
+        ++offs;
     }
 
-    if (init) {
-        init = 0;
+    m->offs = offs;
+    m->hash = hash;
+
+    return n;
+}
+
+static size_t rabin_karp_next(struct string_matcher *m)
+{
+    size_t offs;
+
+    return rabin_karp_find_all(m, &offs, 1) ? offs : m->text_len;
+}
+
+static int rabin_karp_stream_next(struct string_matcher *m)
+{
+    struct rabin_karp_pattern const *p = m->pattern;
+
+    /* m->window is a ring buffer holding the last comp_len characters of the
+       stream, the oldest one is located at (stream offset % comp_len) */
+    size_t const comp_len = m->comp_len;
+
+    while (m->offs < m->text_len) {
+        unsigned char c = m->text[m->offs];
+        size_t seen = m->stream_offs + m->offs;
+        size_t oldest = seen % comp_len;
 
-        comp_len = strlen(comp);
+        if (seen < comp_len)
+            m->hash = hash_push(m->hash, c);
+        else
+            m->hash = hash_roll(m->hash, p->msd, m->window[oldest], c);
 
-        msd = 1;
-        text_val = 0;
-        comp_val = 0;
-        for (size_t i = 0u; i < comp_len; ++i) {
-            if (i != comp_len - 1)
-                msd = (msd << 8) % Q;
+        m->window[oldest] = c;
+        ++m->offs;
 
-            text_val = ((text_val << 8) + text[i]) % Q;
-            comp_val = ((comp_val << 8) + comp[i]) % Q;
+        if (seen + 1 < comp_len || m->hash != p->comp_val)
+            continue;
+
+        STATS_ADD(m, hash_hits, 1u);
+        STATS_ADD(m, verifications, 1u);
+
+        /* window now starts at the following ring buffer position */
+        size_t first = (oldest + 1) % comp_len;
+
+        if (memcmp(m->window + first, m->comp, comp_len - first) == 0 &&
+            memcmp(m->window, m->comp + comp_len - first, first) == 0) {
+            return 1;
         }
 
-        shift = 0u;
+        STATS_ADD(m, hash_collisions, 1u);
+    }
+
+    return 0;
+}
+
+static void rabin_karp_pattern_stats(void const *pattern, size_t comp_len,
+                                     struct string_matcher_stats *stats)
+{
+    stats->table_bytes = sizeof(struct rabin_karp_pattern);
+}
+
+struct string_matcher_ops const string_match_rabin_karp_ops = {
+    .compile = rabin_karp_compile,
+    .free = free,
+    .state_size = NULL,
+    .reset = rabin_karp_reset,
+    .next = rabin_karp_next,
+    .find_all = rabin_karp_find_all,
+    .stream_next = rabin_karp_stream_next,
+    .pattern_stats = rabin_karp_pattern_stats
+};
+
+static struct string_match_static rabin_karp_static;
+
+size_t string_match_rabin_karp(char const *text, char const *comp)
+{
+    return string_match_static(&rabin_karp_static, STRING_MATCH_RABIN_KARP,
+                               text, comp);
+}
+
+size_t string_match_rabin_karp_n(char const *text, size_t text_len,
+                                 char const *comp, size_t comp_len)
+{
+    return string_match_static_n(&rabin_karp_static, STRING_MATCH_RABIN_KARP,
+                                 text, text_len, comp, comp_len);
+}
+
+
+/* multiple patterns, patterns are grouped by length and every group has its
+   own rolling hash and hash table */
+
+struct rabin_karp_group {
+    size_t len;
+    uint64_t msd;
+
+    size_t mask;
+    size_t *buckets; /* first pattern per bucket, chained through next */
+};
+
+struct rabin_karp_multi_pattern {
+    size_t n_groups;
+    struct rabin_karp_group *groups;
+
+    uint64_t *comp_vals;
+    size_t *next;
+
+    char *comps; /* concatenated patterns */
+    size_t *comp_offs;
+};
+
+static void free_rabin_karp_multi(void *pattern)
+{
+    struct rabin_karp_multi_pattern *p = pattern;
+
+    if (p->groups) {
+        for (size_t g = 0u; g < p->n_groups; ++g)
+            free(p->groups[g].buckets);
     }
 
-    while (shift <= end_of_text - comp_len) {
-        size_t ret = end_of_text;
+    free(p->groups);
+    free(p->comp_vals);
+    free(p->next);
+    free(p->comps);
+    free(p->comp_offs);
+    free(p);
+}
+
+static void * compile_rabin_karp_multi(char const * const *comps,
+                                       size_t const *comp_lens, size_t n_comps)
+{
+    struct rabin_karp_multi_pattern *p =
+        calloc(1u, sizeof(struct rabin_karp_multi_pattern));
+    if (!p)
+        return NULL;
+
+    size_t n = n_comps ? n_comps : 1u;
+    size_t total_len = 0u;
+    for (size_t i = 0u; i < n_comps; ++i)
+        total_len += comp_lens[i];
 
-        if (comp_val == text_val && strncmp(text + shift, comp, comp_len) == 0)
-            ret = shift;
+    p->groups = calloc(n, sizeof(struct rabin_karp_group));
+    p->comp_vals = malloc(n * sizeof(uint64_t));
+    p->next = malloc(n * sizeof(size_t));
+    p->comps = malloc(total_len ? total_len : 1u);
+    p->comp_offs = malloc(n * sizeof(size_t));
 
-        if (shift != end_of_text - comp_len) {
-            text_val = (((text_val - text[shift] * msd) << 8) +
-                        text[shift + comp_len]) % Q;
-            if (text_val < 0)
-                text_val += Q;
+    if (!p->groups || !p->comp_vals || !p->next || !p->comps ||
+        !p->comp_offs) {
+        free_rabin_karp_multi(p);
+        return NULL;
+    }
+
+    /* determine groups, p->next and p->comp_offs serve as scratch space until
+       they are filled in below */
+    size_t *group_of = p->next;
+    size_t *group_sizes = p->comp_offs;
+
+    for (size_t i = 0u; i < n_comps; ++i) {
+        if (comp_lens[i] == 0u)
+            continue;
+
+        size_t g = 0u;
+        while (g < p->n_groups && p->groups[g].len != comp_lens[i])
+            ++g;
+
+        if (g == p->n_groups) {
+            p->groups[g].len = comp_lens[i];
+            p->groups[g].msd = hash_msd(comp_lens[i]);
+            group_sizes[g] = 0u;
+            ++p->n_groups;
+        }
+
+        group_of[i] = g;
+        ++group_sizes[g];
+    }
+
+    for (size_t g = 0u; g < p->n_groups; ++g) {
+        size_t buckets = 1u;
+        while (buckets < 2u * group_sizes[g])
+            buckets <<= 1;
+
+        p->groups[g].mask = buckets - 1u;
+        p->groups[g].buckets = malloc(buckets * sizeof(size_t));
+        if (!p->groups[g].buckets) {
+            free_rabin_karp_multi(p);
+            return NULL;
         }
 
-        ++shift;
+        for (size_t b = 0u; b < buckets; ++b)
+            p->groups[g].buckets[b] = NONE;
+    }
+
+    /* fill hash tables, in reverse so that chains are in pattern order */
+    for (size_t i = n_comps; i-- > 0u;) {
+        if (comp_lens[i] == 0u)
+            continue;
+
+        struct rabin_karp_group *group = &p->groups[group_of[i]];
+
+        p->comp_vals[i] = hash_string(comps[i], comp_lens[i]);
+
+        size_t *bucket = &group->buckets[p->comp_vals[i] & group->mask];
+        p->next[i] = *bucket;
+        *bucket = i;
+    }
+
+    size_t offs = 0u;
+    for (size_t i = 0u; i < n_comps; ++i) {
+        if (comp_lens[i] > 0u)
+            memcpy(p->comps + offs, comps[i], comp_lens[i]);
 
-        if (ret != end_of_text)
-            return ret;
+        p->comp_offs[i] = offs;
+        offs += comp_lens[i];
     }
 
-    return end_of_text;
+    return p;
 }
+
+static size_t rabin_karp_multi_state_size(void const *pattern)
+{
+    struct rabin_karp_multi_pattern const *p = pattern;
+
+    return p->n_groups * sizeof(uint64_t);
+}
+
+static void rabin_karp_multi_reset(struct string_multi_matcher *m)
+{
+    struct rabin_karp_multi_pattern const *p = m->pattern;
+
+    uint64_t *hashes = m->scan_state;
+    for (size_t g = 0u; g < p->n_groups; ++g)
+        hashes[g] = 0u;
+
+    /* all groups have been checked for windows ending before offset 0 */
+    m->out_state = p->n_groups;
+    m->out_id = NONE;
+}
+
+static size_t rabin_karp_multi_next(struct string_multi_matcher *m,
+                                    size_t *comp_id)
+{
+    struct rabin_karp_multi_pattern const *p = m->pattern;
+
+    unsigned char const *text = (unsigned char const *) m->text;
+    uint64_t *hashes = m->scan_state;
+
+    /* m->offs is the end of the current windows, m->out_state the next group
+       whose current window has to be looked up and m->out_id the next
+       candidate pattern of the previous group */
+    for (;;) {
+        while (m->out_id != NONE) {
+            size_t id = m->out_id;
+            size_t g = m->out_state - 1u;
+
+            m->out_id = p->next[id];
+
+            size_t len = m->comp_lens[id];
+            size_t start = m->offs - len;
+
+            if (p->comp_vals[id] == hashes[g] &&
+                memcmp(text + start, p->comps + p->comp_offs[id], len) == 0) {
+
+                if (comp_id)
+                    *comp_id = id;
+
+                return start;
+            }
+        }
+
+        if (m->out_state < p->n_groups) {
+            size_t g = m->out_state++;
+            struct rabin_karp_group const *group = &p->groups[g];
+
+            if (m->offs >= group->len)
+                m->out_id = group->buckets[hashes[g] & group->mask];
+
+            continue;
+        }
+
+        if (m->offs == m->text_len)
+            return m->text_len;
+
+        /* advance all windows by one character */
+        unsigned char c = text[m->offs++];
+
+        for (size_t g = 0u; g < p->n_groups; ++g) {
+            size_t len = p->groups[g].len;
+
+            if (m->offs <= len)
+                hashes[g] = hash_push(hashes[g], c);
+            else
+                hashes[g] = hash_roll(hashes[g], p->groups[g].msd,
+                                      text[m->offs - len - 1u], c);
+        }
+
+        m->out_state = 0u;
+    }
+}
+
+struct string_multi_matcher_ops const string_multi_match_rabin_karp_ops = {
+    .compile = compile_rabin_karp_multi,
+    .free = free_rabin_karp_multi,
+    .state_size = rabin_karp_multi_state_size,
+    .reset = rabin_karp_multi_reset,
+    .next = rabin_karp_multi_next
+};
@@ -0,0 +1,198 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+/* Suffix array construction by induced sorting (SA-IS, Nong, Zhang and Chan
+   2009) in O(n). s has to end with a unique smallest character 0, all other
+   characters are in [1, k). */
+
+#define EMPTY SIZE_MAX
+
+static int is_s_type(uint8_t const *types, size_t i)
+{
+    return (types[i >> 3] >> (i & 7)) & 1u;
+}
+
+static int is_lms(uint8_t const *types, size_t i)
+{
+    return i > 0 && is_s_type(types, i) && !is_s_type(types, i - 1);
+}
+
+static void bucket_bounds(size_t const *s, size_t n, size_t k,
+                          size_t *bkt, int ends)
+{
+    memset(bkt, 0, k * sizeof(size_t));
+    for (size_t i = 0; i < n; ++i)
+        ++bkt[s[i]];
+
+    size_t sum = 0;
+    for (size_t c = 0; c < k; ++c) {
+        sum += bkt[c];
+        bkt[c] = ends ? sum : sum - bkt[c];
+    }
+}
+
+static void induce(size_t const *s, size_t *sa, size_t n, size_t k,
+                   uint8_t const *types, size_t *bkt)
+{
+    /* L-type suffixes from left to right */
+    bucket_bounds(s, n, k, bkt, 0);
+    for (size_t i = 0; i < n; ++i) {
+        if (sa[i] != EMPTY && sa[i] > 0 && !is_s_type(types, sa[i] - 1))
+            sa[bkt[s[sa[i] - 1]]++] = sa[i] - 1;
+    }
+
+    /* S-type suffixes from right to left */
+    bucket_bounds(s, n, k, bkt, 1);
+    for (size_t i = n; i-- > 0;) {
+        if (sa[i] != EMPTY && sa[i] > 0 && is_s_type(types, sa[i] - 1))
+            sa[--bkt[s[sa[i] - 1]]] = sa[i] - 1;
+    }
+}
+
+static int lms_equal(size_t const *s, size_t n, uint8_t const *types,
+                     size_t a, size_t b)
+{
+    for (size_t i = 0;; ++i) {
+        if (a + i == n || b + i == n || s[a + i] != s[b + i] ||
+            is_s_type(types, a + i) != is_s_type(types, b + i)) {
+            return 0;
+        }
+
+        if (i > 0 && (is_lms(types, a + i) || is_lms(types, b + i)))
+            return is_lms(types, a + i) && is_lms(types, b + i);
+    }
+}
+
+static int sais(size_t const *s, size_t *sa, size_t n, size_t k)
+{
+    if (n == 1u) {
+        sa[0] = 0u;
+        return 1;
+    }
+
+    uint8_t *types = calloc((n + 7) / 8, 1);
+    size_t *bkt = malloc(k * sizeof(size_t));
+    if (!types || !bkt) {
+        free(types);
+        free(bkt);
+        return 0;
+    }
+
+    types[(n - 1) >> 3] |= 1u << ((n - 1) & 7);
+    for (size_t i = n - 1; i-- > 0;) {
+        if (s[i] < s[i + 1] ||
+            (s[i] == s[i + 1] && is_s_type(types, i + 1))) {
+            types[i >> 3] |= 1u << (i & 7);
+        }
+    }
+
+    /* sort LMS substrings by inducing from their unsorted positions */
+    for (size_t i = 0; i < n; ++i)
+        sa[i] = EMPTY;
+
+    bucket_bounds(s, n, k, bkt, 1);
+    for (size_t i = 1; i < n; ++i) {
+        if (is_lms(types, i))
+            sa[--bkt[s[i]]] = i;
+    }
+
+    induce(s, sa, n, k, types, bkt);
+
+    /* compact sorted LMS substrings into sa[0, n1) and name them, names are
+       stored in sa[n1 + pos / 2] which does not collide for LMS positions
+       that are at least two apart */
+    size_t n1 = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (is_lms(types, sa[i]))
+            sa[n1++] = sa[i];
+    }
+
+    for (size_t i = n1; i < n; ++i)
+        sa[i] = EMPTY;
+
+    size_t name = 0;
+    size_t prev = EMPTY;
+    for (size_t i = 0; i < n1; ++i) {
+        size_t pos = sa[i];
+        if (prev == EMPTY || !lms_equal(s, n, types, pos, prev))
+            ++name;
+        prev = pos;
+        sa[n1 + pos / 2] = name - 1;
+    }
+
+    size_t *s1 = malloc(n1 * sizeof(size_t));
+    size_t *lms = malloc(n1 * sizeof(size_t));
+    if (!s1 || !lms) {
+        free(s1);
+        free(lms);
+        free(types);
+        free(bkt);
+        return 0;
+    }
+
+    for (size_t i = n1, j = n; j-- > n1;) {
+        if (sa[j] != EMPTY)
+            s1[--i] = sa[j];
+    }
+
+    /* sort LMS suffixes, recursively unless all names are unique */
+    if (name < n1) {
+        if (!sais(s1, sa, n1, name)) {
+            free(s1);
+            free(lms);
+            free(types);
+            free(bkt);
+            return 0;
+        }
+    } else {
+        for (size_t i = 0; i < n1; ++i)
+            sa[s1[i]] = i;
+    }
+
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        if (is_lms(types, i))
+            lms[j++] = i;
+    }
+
+    for (size_t i = 0; i < n1; ++i)
+        s1[i] = lms[sa[i]];
+
+    /* induce all suffixes from the sorted LMS suffixes */
+    for (size_t i = 0; i < n; ++i)
+        sa[i] = EMPTY;
+
+    bucket_bounds(s, n, k, bkt, 1);
+    for (size_t i = n1; i-- > 0;)
+        sa[--bkt[s[s1[i]]]] = s1[i];
+
+    induce(s, sa, n, k, types, bkt);
+
+    free(s1);
+    free(lms);
+    free(types);
+    free(bkt);
+
+    return 1;
+}
+
+int string_index_suffix_array(unsigned char const *text, size_t text_len,
+                              size_t *sa)
+{
+    size_t *s = malloc((text_len + 1) * sizeof(size_t));
+    if (!s)
+        return 0;
+
+    for (size_t i = 0; i < text_len; ++i)
+        s[i] = (size_t) text[i] + 1;
+    s[text_len] = 0;
+
+    int ret = sais(s, sa, text_len + 1, 257);
+
+    free(s);
+
+    return ret;
+}
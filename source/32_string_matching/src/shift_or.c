@@ -0,0 +1,252 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+/* Bit parallel Shift-Or, bit i of the state word is clear if the last i + 1
+   characters read match the first i + 1 pattern characters. The automaton
+   covers the first WORD_BITS pattern characters, the remainder of longer
+   patterns is compared once the automaton has found a prefix. */
+
+#define WORD_BITS (sizeof(size_t) * CHAR_BIT)
+
+struct shift_or_pattern {
+    size_t len;  /* number of pattern characters in the automaton */
+    size_t k;    /* number of allowed mismatches */
+    size_t masks[256];
+};
+
+static struct shift_or_pattern * compile_masks(char const *comp,
+                                               size_t comp_len)
+{
+    struct shift_or_pattern *p = malloc(sizeof(struct shift_or_pattern));
+    if (!p)
+        return NULL;
+
+    p->len = comp_len < WORD_BITS ? comp_len : WORD_BITS;
+    p->k = 0;
+
+    for (size_t c = 0; c < 256; ++c)
+        p->masks[c] = ~(size_t) 0;
+    for (size_t i = 0; i < p->len; ++i)
+        p->masks[(unsigned char) comp[i]] &= ~((size_t) 1 << i);
+
+    return p;
+}
+
+
+/* exact matching */
+
+static void * shift_or_compile(char const *comp, size_t comp_len)
+{
+    return compile_masks(comp, comp_len);
+}
+
+static size_t shift_or_find_all(struct string_matcher *m,
+                                size_t *matches, size_t max_matches)
+{
+    struct shift_or_pattern const *p = m->pattern;
+
+    unsigned char const *text = (unsigned char const *) m->text;
+    size_t const *masks = p->masks;
+    size_t const len = p->len;
+    size_t const rest = m->comp_len - len;
+    size_t const found = (size_t) 1 << (len - 1);
+
+    /* prefixes found after end can not be completed to a match */
+    size_t offs = m->offs;
+    size_t const end = m->text_len - rest;
+    size_t state = m->state;
+    size_t n = 0;
+
+    while (offs < end && n < max_matches) {
+        state = (state << 1) | masks[text[offs++]];
+
+        if (!(state & found)) {
+            STATS_ADD(m, verifications, rest > 0);
+
+            if (rest == 0 || memcmp(text + offs, m->comp + len, rest) == 0)
+                matches[n++] = offs - len;
+        }
+    }
+
+    STATS_ADD(m, chars_compared, offs - m->offs);
+
+    m->offs = offs;
+    m->state = state;
+
+    return n;
+}
+
+static void shift_or_reset(struct string_matcher *m)
+{
+    m->state = ~(size_t) 0;
+}
+
+static size_t shift_or_next(struct string_matcher *m)
+{
+    size_t offs;
+
+    return shift_or_find_all(m, &offs, 1) ? offs : m->text_len;
+}
+
+static void shift_or_pattern_stats(void const *pattern, size_t comp_len,
+                                   struct string_matcher_stats *stats)
+{
+    stats->table_bytes = sizeof(struct shift_or_pattern);
+}
+
+struct string_matcher_ops const string_match_shift_or_ops = {
+    .compile = shift_or_compile,
+    .free = free,
+    .state_size = NULL,
+    .reset = shift_or_reset,
+    .next = shift_or_next,
+    .find_all = shift_or_find_all,
+    .stream_next = NULL,
+    .pattern_stats = shift_or_pattern_stats
+};
+
+static struct string_match_static shift_or_static;
+
+size_t string_match_shift_or(char const *text, char const *comp)
+{
+    return string_match_static(&shift_or_static, STRING_MATCH_SHIFT_OR,
+                               text, comp);
+}
+
+size_t string_match_shift_or_n(char const *text, size_t text_len,
+                               char const *comp, size_t comp_len)
+{
+    return string_match_static_n(&shift_or_static, STRING_MATCH_SHIFT_OR,
+                                 text, text_len, comp, comp_len);
+}
+
+
+/* approximate matching with up to k mismatches, state word d is the exact
+   automaton for d mismatches, a character either advances state d or
+   advances state d - 1 as a mismatch */
+
+static size_t approx_state_size(void const *pattern)
+{
+    struct shift_or_pattern const *p = pattern;
+
+    return (p->k + 1) * sizeof(size_t);
+}
+
+static void approx_reset(struct string_matcher *m)
+{
+    struct shift_or_pattern const *p = m->pattern;
+
+    size_t *states = m->scan_state;
+    for (size_t d = 0; d <= p->k; ++d)
+        states[d] = ~(size_t) 0;
+}
+
+static size_t approx_find_all(struct string_matcher *m,
+                              size_t *matches, size_t max_matches)
+{
+    struct shift_or_pattern const *p = m->pattern;
+
+    unsigned char const *text = (unsigned char const *) m->text;
+    size_t const k = p->k;
+    size_t const found = (size_t) 1 << (p->len - 1);
+
+    size_t *states = m->scan_state;
+    size_t offs = m->offs;
+    size_t const end = m->text_len;
+    size_t n = 0;
+
+    while (offs < end && n < max_matches) {
+        size_t mask = p->masks[text[offs++]];
+
+        size_t prev = states[0];
+        states[0] = (prev << 1) | mask;
+
+        for (size_t d = 1; d <= k; ++d) {
+            size_t cur = states[d];
+            states[d] = ((cur << 1) | mask) & (prev << 1);
+            prev = cur;
+        }
+
+        if (!(states[k] & found))
+            matches[n++] = offs - p->len;
+    }
+
+    STATS_ADD(m, chars_compared, offs - m->offs);
+
+    m->offs = offs;
+
+    return n;
+}
+
+static size_t approx_next(struct string_matcher *m)
+{
+    size_t offs;
+
+    return approx_find_all(m, &offs, 1) ? offs : m->text_len;
+}
+
+static struct string_matcher_ops const approx_ops = {
+    .compile = NULL,
+    .free = free,
+    .state_size = approx_state_size,
+    .reset = approx_reset,
+    .next = approx_next,
+    .find_all = approx_find_all,
+    .stream_next = NULL,
+    .pattern_stats = shift_or_pattern_stats
+};
+
+struct string_pattern * string_pattern_compile_approx(char const *comp,
+                                                      size_t k)
+{
+    if (!comp)
+        return NULL;
+
+    return string_pattern_compile_approx_n(comp, strlen(comp), k);
+}
+
+struct string_pattern * string_pattern_compile_approx_n(char const *comp,
+                                                        size_t comp_len,
+                                                        size_t k)
+{
+    if (!comp || comp_len == 0 || comp_len > WORD_BITS)
+        return NULL;
+
+    struct shift_or_pattern *p = compile_masks(comp, comp_len);
+    if (!p)
+        return NULL;
+
+    p->k = k < comp_len ? k : comp_len;
+
+    return string_pattern_create(&approx_ops, STRING_MATCH_SHIFT_OR,
+                                 comp, comp_len, p);
+}
+
+struct string_matcher * string_matcher_create_approx(char const *comp,
+                                                     size_t k)
+{
+    if (!comp)
+        return NULL;
+
+    return string_matcher_create_approx_n(comp, strlen(comp), k);
+}
+
+struct string_matcher * string_matcher_create_approx_n(char const *comp,
+                                                       size_t comp_len,
+                                                       size_t k)
+{
+    struct string_pattern *p = string_pattern_compile_approx_n(comp, comp_len,
+                                                               k);
+    if (!p)
+        return NULL;
+
+    struct string_matcher *m = string_matcher_create_from_pattern(p);
+
+    string_pattern_free(p);
+
+    return m;
+}
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+struct string_stream_matcher {
+    struct string_matcher *m;
+};
+
+struct string_stream_matcher * string_stream_matcher_create(
+    enum string_match_engine engine, char const *comp)
+{
+    if (!comp)
+        return NULL;
+
+    return string_stream_matcher_create_n(engine, comp, strlen(comp));
+}
+
+struct string_stream_matcher * string_stream_matcher_create_n(
+    enum string_match_engine engine, char const *comp, size_t comp_len)
+{
+    struct string_stream_matcher *s =
+        malloc(sizeof(struct string_stream_matcher));
+    if (!s)
+        return NULL;
+
+    s->m = string_matcher_create_n(engine, comp, comp_len);
+    if (!s->m || !s->m->ops->stream_next) {
+        string_matcher_free(s->m);
+        free(s);
+        return NULL;
+    }
+
+    if (s->m->comp_len > 0u) {
+        s->m->window = malloc(s->m->comp_len);
+        if (!s->m->window) {
+            string_matcher_free(s->m);
+            free(s);
+            return NULL;
+        }
+    }
+
+    string_stream_matcher_reset(s);
+
+    return s;
+}
+
+void string_stream_matcher_free(struct string_stream_matcher *s)
+{
+    if (!s)
+        return;
+
+    string_matcher_free(s->m);
+    free(s);
+}
+
+void string_stream_matcher_reset(struct string_stream_matcher *s)
+{
+    struct string_matcher *m = s->m;
+
+    m->text = NULL;
+    m->text_len = 0u;
+    m->offs = 0u;
+    m->state = 0u;
+    m->hash = 0;
+    m->stream_offs = 0u;
+}
+
+size_t string_stream_matcher_feed(struct string_stream_matcher *s,
+                                  char const *chunk, size_t chunk_len)
+{
+    struct string_matcher *m = s->m;
+
+    m->stream_offs += m->text_len;
+    m->text = chunk;
+    m->text_len = chunk_len;
+    m->offs = 0u;
+
+    return m->stream_offs + m->text_len;
+}
+
+size_t string_stream_matcher_next(struct string_stream_matcher *s)
+{
+    struct string_matcher *m = s->m;
+
+    if (m->comp_len == 0u || !m->ops->stream_next(m))
+        return m->stream_offs + m->text_len;
+
+    STATS_ADD(m, matches, 1u);
+
+    return m->stream_offs + m->offs - m->comp_len;
+}
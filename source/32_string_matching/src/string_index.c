@@ -0,0 +1,585 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+/* The suffix array index answers queries by binary search over the sorted
+   suffixes of the text. The FM-index answers them by backward search over
+   the Burrows-Wheeler transform, row r of the BWT is the character before
+   the r-th smallest suffix, with the empty suffix in row 0 and a sentinel
+   smaller than all characters in the row of the suffix starting at 0.
+   Characters are mapped to dense codes so that the rank samples only cover
+   the characters present in the text. */
+
+/* ranks are sampled every BLOCK_LEN rows relative to the enclosing
+   superblock, so that they fit into 16 bits */
+#define BLOCK_LEN 128u
+#define SUPERBLOCK_LEN 65536u
+
+#define NO_CODE UINT16_MAX
+
+static char const index_magic[8] = "STRIDX01";
+
+struct string_index {
+    enum string_index_type type;
+    size_t text_len;
+
+    /* suffix array index */
+    unsigned char *text;
+    size_t *sa;              /* the empty suffix is omitted */
+
+    /* FM-index over text_len + 1 rows */
+    size_t sigma;            /* number of distinct characters */
+    size_t primary;          /* row of the suffix starting at 0 */
+    uint16_t codes[256];     /* dense character codes or NO_CODE */
+    size_t first[257];       /* first row of the suffixes starting with code */
+    unsigned char *bwt;      /* codes, the sentinel in row primary is 0 */
+    size_t *superblocks;     /* sigma ranks per superblock */
+    uint16_t *blocks;        /* sigma ranks per block */
+    uint64_t *sampled;       /* rows whose suffix array entry is sampled */
+    size_t *sampled_ranks;   /* sampled rows before each word of sampled */
+    size_t *samples;         /* sampled suffix array entries in row order */
+};
+
+static size_t n_superblocks(struct string_index const *idx)
+{
+    return (idx->text_len + 1u) / SUPERBLOCK_LEN + 1u;
+}
+
+static size_t n_blocks(struct string_index const *idx)
+{
+    return (idx->text_len + 1u) / BLOCK_LEN + 1u;
+}
+
+static size_t n_words(struct string_index const *idx)
+{
+    return (idx->text_len + 1u) / 64u + 1u;
+}
+
+static size_t n_samples(struct string_index const *idx)
+{
+    return idx->text_len / STRING_INDEX_SAMPLE_RATE + 1u;
+}
+
+static void * alloc_array(size_t n, size_t size)
+{
+    if (size > 0u && n > SIZE_MAX / size)
+        return NULL;
+
+    return malloc(n ? n * size : 1u);
+}
+
+/* allocate the arrays for idx->type, idx->text_len and idx->sigma */
+static int alloc_index(struct string_index *idx)
+{
+    size_t rows = idx->text_len + 1u;
+
+    if (idx->type == STRING_INDEX_SUFFIX_ARRAY) {
+        idx->text = alloc_array(idx->text_len, 1u);
+        idx->sa = alloc_array(rows, sizeof(size_t));
+
+        return idx->text && idx->sa;
+    }
+
+    idx->bwt = alloc_array(rows, 1u);
+    idx->superblocks = alloc_array(n_superblocks(idx),
+                                   idx->sigma * sizeof(size_t));
+    idx->blocks = alloc_array(n_blocks(idx), idx->sigma * sizeof(uint16_t));
+    idx->sampled = alloc_array(n_words(idx), sizeof(uint64_t));
+    idx->sampled_ranks = alloc_array(n_words(idx), sizeof(size_t));
+    idx->samples = alloc_array(n_samples(idx), sizeof(size_t));
+
+    return idx->bwt && idx->superblocks && idx->blocks && idx->sampled &&
+           idx->sampled_ranks && idx->samples;
+}
+
+void string_index_free(struct string_index *idx)
+{
+    if (!idx)
+        return;
+
+    free(idx->text);
+    free(idx->sa);
+    free(idx->bwt);
+    free(idx->superblocks);
+    free(idx->blocks);
+    free(idx->sampled);
+    free(idx->sampled_ranks);
+    free(idx->samples);
+    free(idx);
+}
+
+
+/* construction */
+
+/* derive the first rows and all rank samples from bwt and sampled */
+static void build_ranks(struct string_index *idx)
+{
+    size_t const rows = idx->text_len + 1u;
+    size_t const sigma = idx->sigma;
+
+    size_t counts[256] = {0};
+    for (size_t r = 0u; r <= rows; ++r) {
+        if (r % SUPERBLOCK_LEN == 0u)
+            memcpy(idx->superblocks + r / SUPERBLOCK_LEN * sigma, counts,
+                   sigma * sizeof(size_t));
+
+        if (r % BLOCK_LEN == 0u) {
+            size_t const *super = idx->superblocks +
+                                  r / SUPERBLOCK_LEN * sigma;
+            for (size_t c = 0u; c < sigma; ++c)
+                idx->blocks[r / BLOCK_LEN * sigma + c] =
+                    (uint16_t) (counts[c] - super[c]);
+        }
+
+        if (r < rows)
+            ++counts[idx->bwt[r]];
+    }
+
+    /* the sentinel sorts before all characters */
+    --counts[0];
+
+    idx->first[0] = 1u;
+    for (size_t c = 0u; c < sigma; ++c)
+        idx->first[c + 1u] = idx->first[c] + counts[c];
+
+    size_t n = 0u;
+    for (size_t w = 0u; w < n_words(idx); ++w) {
+        idx->sampled_ranks[w] = n;
+        n += (size_t) __builtin_popcountll(idx->sampled[w]);
+    }
+}
+
+static void build_fm(struct string_index *idx, unsigned char const *text,
+                     size_t const *sa)
+{
+    memset(idx->sampled, 0, n_words(idx) * sizeof(uint64_t));
+
+    size_t n = 0u;
+    for (size_t r = 0u; r <= idx->text_len; ++r) {
+        if (sa[r] > 0u) {
+            idx->bwt[r] = (unsigned char) idx->codes[text[sa[r] - 1u]];
+        } else {
+            idx->bwt[r] = 0u;
+            idx->primary = r;
+        }
+
+        if (sa[r] % STRING_INDEX_SAMPLE_RATE == 0u) {
+            idx->sampled[r / 64u] |= (uint64_t) 1 << (r % 64u);
+            idx->samples[n++] = sa[r];
+        }
+    }
+
+    build_ranks(idx);
+}
+
+struct string_index * string_index_create(enum string_index_type type,
+                                          char const *text)
+{
+    if (!text)
+        return NULL;
+
+    return string_index_create_n(type, text, strlen(text));
+}
+
+struct string_index * string_index_create_n(enum string_index_type type,
+                                            char const *text,
+                                            size_t text_len)
+{
+    if (!text ||
+        (type != STRING_INDEX_SUFFIX_ARRAY && type != STRING_INDEX_FM))
+        return NULL;
+
+    struct string_index *idx = calloc(1u, sizeof(struct string_index));
+    if (!idx)
+        return NULL;
+
+    idx->type = type;
+    idx->text_len = text_len;
+
+    unsigned char const *t = (unsigned char const *) text;
+
+    int seen[256] = {0};
+    for (size_t i = 0u; i < text_len; ++i)
+        seen[t[i]] = 1;
+
+    for (size_t c = 0u; c < 256u; ++c)
+        idx->codes[c] = seen[c] ? (uint16_t) idx->sigma++ : NO_CODE;
+
+    if (!alloc_index(idx)) {
+        string_index_free(idx);
+        return NULL;
+    }
+
+    size_t *sa = idx->sa ? idx->sa :
+                 alloc_array(text_len + 1u, sizeof(size_t));
+
+    if (!sa || !string_index_suffix_array(t, text_len, sa)) {
+        if (sa != idx->sa)
+            free(sa);
+        string_index_free(idx);
+        return NULL;
+    }
+
+    if (type == STRING_INDEX_SUFFIX_ARRAY) {
+        /* the empty suffix always comes first */
+        memmove(sa, sa + 1, text_len * sizeof(size_t));
+        memcpy(idx->text, text, text_len);
+    } else {
+        build_fm(idx, t, sa);
+        free(sa);
+    }
+
+    return idx;
+}
+
+
+/* suffix array queries */
+
+/* compare the suffix starting at pos to comp, zero if comp is its prefix */
+static int compare_suffix(struct string_index const *idx, size_t pos,
+                          char const *comp, size_t comp_len)
+{
+    size_t len = idx->text_len - pos;
+
+    int cmp = memcmp(idx->text + pos, comp, len < comp_len ? len : comp_len);
+    if (cmp == 0 && len < comp_len)
+        return -1;
+
+    return cmp;
+}
+
+static size_t sa_range(struct string_index const *idx,
+                       char const *comp, size_t comp_len, size_t *start)
+{
+    size_t lo = 0u;
+    size_t hi = idx->text_len;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2u;
+        if (compare_suffix(idx, idx->sa[mid], comp, comp_len) < 0)
+            lo = mid + 1u;
+        else
+            hi = mid;
+    }
+
+    *start = lo;
+
+    hi = idx->text_len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2u;
+        if (compare_suffix(idx, idx->sa[mid], comp, comp_len) <= 0)
+            lo = mid + 1u;
+        else
+            hi = mid;
+    }
+
+    return lo - *start;
+}
+
+
+/* FM-index queries */
+
+/* occurrences of code c in bwt[0, r) */
+static size_t rank(struct string_index const *idx, size_t c, size_t r)
+{
+    size_t const sigma = idx->sigma;
+    size_t block = r / BLOCK_LEN;
+
+    size_t n = idx->superblocks[r / SUPERBLOCK_LEN * sigma + c] +
+               idx->blocks[block * sigma + c];
+
+    unsigned char const *bwt = idx->bwt;
+    for (size_t i = block * BLOCK_LEN; i < r; ++i)
+        n += bwt[i] == c;
+
+    /* the sentinel is stored as code 0 */
+    if (c == 0u && idx->primary < r)
+        --n;
+
+    return n;
+}
+
+static size_t fm_range(struct string_index const *idx,
+                       char const *comp, size_t comp_len, size_t *start)
+{
+    size_t sp = 0u;
+    size_t ep = idx->text_len + 1u;
+
+    for (size_t i = comp_len; i-- > 0u && sp < ep;) {
+        size_t c = idx->codes[(unsigned char) comp[i]];
+        if (c == NO_CODE)
+            return 0u;
+
+        sp = idx->first[c] + rank(idx, c, sp);
+        ep = idx->first[c] + rank(idx, c, ep);
+    }
+
+    *start = sp;
+
+    return sp < ep ? ep - sp : 0u;
+}
+
+static size_t fm_locate(struct string_index const *idx, size_t r)
+{
+    /* walk backwards through the text until a sampled row is reached, the
+       row of the suffix starting at 0 is always sampled */
+    size_t steps = 0u;
+
+    while (!(idx->sampled[r / 64u] & ((uint64_t) 1 << (r % 64u)))) {
+        size_t c = idx->bwt[r];
+        r = idx->first[c] + rank(idx, c, r);
+        ++steps;
+    }
+
+    uint64_t below = idx->sampled[r / 64u] &
+                     (((uint64_t) 1 << (r % 64u)) - 1u);
+    size_t i = idx->sampled_ranks[r / 64u] +
+               (size_t) __builtin_popcountll(below);
+
+    return idx->samples[i] + steps;
+}
+
+
+/* queries */
+
+static size_t index_range(struct string_index const *idx,
+                          char const *comp, size_t comp_len, size_t *start)
+{
+    *start = 0u;
+
+    if (comp_len == 0u || comp_len > idx->text_len)
+        return 0u;
+
+    if (idx->type == STRING_INDEX_SUFFIX_ARRAY)
+        return sa_range(idx, comp, comp_len, start);
+
+    return fm_range(idx, comp, comp_len, start);
+}
+
+static int compare_offsets(void const *a, void const *b)
+{
+    size_t x = *(size_t const *) a;
+    size_t y = *(size_t const *) b;
+
+    return (x > y) - (x < y);
+}
+
+size_t string_index_count(struct string_index const *idx, char const *comp)
+{
+    if (!comp)
+        return 0u;
+
+    return string_index_count_n(idx, comp, strlen(comp));
+}
+
+size_t string_index_count_n(struct string_index const *idx,
+                            char const *comp, size_t comp_len)
+{
+    size_t start;
+
+    if (!idx || !comp)
+        return 0u;
+
+    return index_range(idx, comp, comp_len, &start);
+}
+
+size_t string_index_locate(struct string_index const *idx, char const *comp,
+                           size_t **matches)
+{
+    if (!comp) {
+        *matches = NULL;
+        return 0u;
+    }
+
+    return string_index_locate_n(idx, comp, strlen(comp), matches);
+}
+
+size_t string_index_locate_n(struct string_index const *idx,
+                             char const *comp, size_t comp_len,
+                             size_t **matches)
+{
+    size_t start;
+
+    *matches = NULL;
+
+    if (!idx || !comp)
+        return 0u;
+
+    size_t n = index_range(idx, comp, comp_len, &start);
+    if (n == 0u)
+        return 0u;
+
+    *matches = malloc(n * sizeof(size_t));
+    if (!*matches)
+        return (size_t) -1;
+
+    for (size_t i = 0u; i < n; ++i) {
+        (*matches)[i] = idx->type == STRING_INDEX_SUFFIX_ARRAY ?
+                        idx->sa[start + i] : fm_locate(idx, start + i);
+    }
+
+    qsort(*matches, n, sizeof(size_t), compare_offsets);
+
+    return n;
+}
+
+
+/* persistence, a fixed header followed by the arrays of the index type, the
+   rank samples of the FM-index are rebuilt on load */
+
+static int write_array(FILE *f, void const *data, size_t n, size_t size)
+{
+    return n == 0u || fwrite(data, size, n, f) == n;
+}
+
+static int read_array(FILE *f, void *data, size_t n, size_t size)
+{
+    return n == 0u || fread(data, size, n, f) == n;
+}
+
+int string_index_save(struct string_index const *idx, char const *path)
+{
+    if (!idx || !path)
+        return 0;
+
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return 0;
+
+    uint32_t header[2] = { (uint32_t) idx->type, (uint32_t) sizeof(size_t) };
+    size_t rows = idx->text_len + 1u;
+
+    int ok = write_array(f, index_magic, sizeof(index_magic), 1u) &&
+             write_array(f, header, 2u, sizeof(uint32_t)) &&
+             write_array(f, &idx->text_len, 1u, sizeof(size_t));
+
+    if (idx->type == STRING_INDEX_SUFFIX_ARRAY) {
+        ok = ok &&
+             write_array(f, idx->text, idx->text_len, 1u) &&
+             write_array(f, idx->sa, idx->text_len, sizeof(size_t));
+    } else {
+        ok = ok &&
+             write_array(f, &idx->sigma, 1u, sizeof(size_t)) &&
+             write_array(f, &idx->primary, 1u, sizeof(size_t)) &&
+             write_array(f, idx->codes, 256u, sizeof(uint16_t)) &&
+             write_array(f, idx->bwt, rows, 1u) &&
+             write_array(f, idx->sampled, n_words(idx), sizeof(uint64_t)) &&
+             write_array(f, idx->samples, n_samples(idx), sizeof(size_t));
+    }
+
+    if (fclose(f) != 0)
+        ok = 0;
+
+    return ok;
+}
+
+/* reject indexes that would make queries access memory out of bounds and
+   derive the rank samples, the file is trusted to hold a valid BWT */
+static int check_fm(struct string_index *idx)
+{
+    size_t rows = idx->text_len + 1u;
+
+    if (idx->primary >= rows || (idx->text_len > 0u && idx->sigma == 0u))
+        return 0;
+
+    for (size_t c = 0u; c < 256u; ++c) {
+        if (idx->codes[c] != NO_CODE && idx->codes[c] >= idx->sigma)
+            return 0;
+    }
+
+    idx->bwt[idx->primary] = 0u;
+    for (size_t r = 0u; r < rows; ++r) {
+        if (r != idx->primary && idx->bwt[r] >= idx->sigma)
+            return 0;
+    }
+
+    /* only the bits of the rows may be set */
+    size_t last_bits = rows % 64u;
+    if (idx->sampled[rows / 64u] & ~(((uint64_t) 1 << last_bits) - 1u))
+        return 0;
+
+    build_ranks(idx);
+
+    size_t w = n_words(idx) - 1u;
+    if (idx->sampled_ranks[w] +
+        (size_t) __builtin_popcountll(idx->sampled[w]) != n_samples(idx) ||
+        !(idx->sampled[idx->primary / 64u] &
+          ((uint64_t) 1 << (idx->primary % 64u))))
+        return 0;
+
+    for (size_t i = 0u; i < n_samples(idx); ++i) {
+        if (idx->samples[i] > idx->text_len)
+            return 0;
+    }
+
+    return 1;
+}
+
+struct string_index * string_index_load(char const *path)
+{
+    if (!path)
+        return NULL;
+
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+
+    char magic[sizeof(index_magic)];
+    uint32_t header[2];
+    size_t text_len;
+
+    if (!read_array(f, magic, sizeof(magic), 1u) ||
+        !read_array(f, header, 2u, sizeof(uint32_t)) ||
+        !read_array(f, &text_len, 1u, sizeof(size_t)) ||
+        memcmp(magic, index_magic, sizeof(magic)) != 0 ||
+        (header[0] != STRING_INDEX_SUFFIX_ARRAY &&
+         header[0] != STRING_INDEX_FM) ||
+        header[1] != sizeof(size_t) || text_len == SIZE_MAX) {
+        fclose(f);
+        return NULL;
+    }
+
+    struct string_index *idx = calloc(1u, sizeof(struct string_index));
+    if (!idx) {
+        fclose(f);
+        return NULL;
+    }
+
+    idx->type = (enum string_index_type) header[0];
+    idx->text_len = text_len;
+
+    int ok;
+    size_t rows = text_len + 1u;
+
+    if (idx->type == STRING_INDEX_SUFFIX_ARRAY) {
+        ok = alloc_index(idx) &&
+             read_array(f, idx->text, text_len, 1u) &&
+             read_array(f, idx->sa, text_len, sizeof(size_t));
+
+        for (size_t i = 0u; ok && i < text_len; ++i)
+            ok = idx->sa[i] < text_len;
+    } else {
+        ok = read_array(f, &idx->sigma, 1u, sizeof(size_t)) &&
+             read_array(f, &idx->primary, 1u, sizeof(size_t)) &&
+             idx->sigma <= 256u &&
+             alloc_index(idx) &&
+             read_array(f, idx->codes, 256u, sizeof(uint16_t)) &&
+             read_array(f, idx->bwt, rows, 1u) &&
+             read_array(f, idx->sampled, n_words(idx), sizeof(uint64_t)) &&
+             read_array(f, idx->samples, n_samples(idx), sizeof(size_t)) &&
+             check_fm(idx);
+    }
+
+    fclose(f);
+
+    if (!ok) {
+        string_index_free(idx);
+        return NULL;
+    }
+
+    return idx;
+}
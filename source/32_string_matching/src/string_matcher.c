@@ -0,0 +1,492 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+static struct string_matcher_ops const *engine_ops(
+    enum string_match_engine engine)
+{
+    switch (engine) {
+    case STRING_MATCH_NAIVE:
+        return &string_match_naive_ops;
+    case STRING_MATCH_RABIN_KARP:
+        return &string_match_rabin_karp_ops;
+    case STRING_MATCH_DFA:
+        return &string_match_dfa_ops;
+    case STRING_MATCH_KMP:
+        return &string_match_kmp_ops;
+    case STRING_MATCH_BOYER_MOORE:
+        return &string_match_boyer_moore_ops;
+    case STRING_MATCH_TWO_WAY:
+        return &string_match_two_way_ops;
+    case STRING_MATCH_SHIFT_OR:
+        return &string_match_shift_or_ops;
+    case STRING_MATCH_BNDM:
+        return &string_match_bndm_ops;
+    case STRING_MATCH_AUTO:
+        return &string_match_auto_ops;
+    }
+
+    return NULL;
+}
+
+
+/* compiled patterns */
+
+struct string_pattern * string_pattern_compile(enum string_match_engine engine,
+                                               char const *comp)
+{
+    if (!comp)
+        return NULL;
+
+    return string_pattern_compile_n(engine, comp, strlen(comp));
+}
+
+struct string_pattern * string_pattern_compile_n(
+    enum string_match_engine engine, char const *comp, size_t comp_len)
+{
+    struct string_matcher_ops const *ops = engine_ops(engine);
+    if (!ops || (!comp && comp_len > 0))
+        return NULL;
+
+#ifdef STRING_MATCH_STATS
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+#endif
+
+    void *pattern = NULL;
+    if (comp_len > 0 && ops->compile) {
+        pattern = ops->compile(comp, comp_len);
+        if (!pattern)
+            return NULL;
+    }
+
+#ifdef STRING_MATCH_STATS
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    struct string_pattern *p = string_pattern_create(ops, engine,
+                                                     comp, comp_len, pattern);
+    if (p)
+        p->compile_ns = (size_t) (end.tv_sec - start.tv_sec) * 1000000000u +
+                        (size_t) end.tv_nsec - (size_t) start.tv_nsec;
+
+    return p;
+#else
+    return string_pattern_create(ops, engine, comp, comp_len, pattern);
+#endif
+}
+
+struct string_pattern * string_pattern_create(
+    struct string_matcher_ops const *ops, enum string_match_engine engine,
+    char const *comp, size_t comp_len, void *pattern)
+{
+    struct string_pattern *p = malloc(sizeof(struct string_pattern));
+    if (!p) {
+        if (pattern && ops->free)
+            ops->free(pattern);
+        return NULL;
+    }
+
+    p->ops = ops;
+    p->engine = engine;
+    p->refs = 1u;
+    p->pattern = pattern;
+
+    p->comp_len = comp_len;
+    p->comp = malloc(comp_len + 1);
+    if (!p->comp) {
+        if (pattern && ops->free)
+            ops->free(pattern);
+        free(p);
+        return NULL;
+    }
+    if (comp_len > 0)
+        memcpy(p->comp, comp, comp_len);
+    p->comp[comp_len] = '\0';
+
+#ifdef STRING_MATCH_STATS
+    p->compile_ns = 0u;
+#endif
+
+    return p;
+}
+
+struct string_pattern * string_pattern_ref(struct string_pattern *p)
+{
+    __atomic_add_fetch(&p->refs, 1u, __ATOMIC_RELAXED);
+
+    return p;
+}
+
+void string_pattern_free(struct string_pattern *p)
+{
+    if (!p || __atomic_sub_fetch(&p->refs, 1u, __ATOMIC_ACQ_REL) > 0u)
+        return;
+
+    if (p->pattern && p->ops->free)
+        p->ops->free(p->pattern);
+
+    free(p->comp);
+    free(p);
+}
+
+
+/* reentrant matchers */
+
+struct string_matcher * string_matcher_create(enum string_match_engine engine,
+                                              char const *comp)
+{
+    if (!comp)
+        return NULL;
+
+    return string_matcher_create_n(engine, comp, strlen(comp));
+}
+
+struct string_matcher * string_matcher_create_n(
+    enum string_match_engine engine, char const *comp, size_t comp_len)
+{
+    struct string_pattern *p = string_pattern_compile_n(engine, comp, comp_len);
+    if (!p)
+        return NULL;
+
+    struct string_matcher *m = string_matcher_create_from_pattern(p);
+
+    string_pattern_free(p);
+
+    return m;
+}
+
+struct string_matcher * string_matcher_create_from_pattern(
+    struct string_pattern *p)
+{
+    if (!p)
+        return NULL;
+
+    struct string_matcher *m = malloc(sizeof(struct string_matcher));
+    if (!m)
+        return NULL;
+
+    m->scan_state = NULL;
+    size_t state_size = p->pattern && p->ops->state_size ?
+        p->ops->state_size(p->pattern) : 0u;
+    if (state_size > 0u) {
+        m->scan_state = malloc(state_size);
+        if (!m->scan_state) {
+            free(m);
+            return NULL;
+        }
+    }
+
+    m->ops = p->ops;
+    m->compiled = string_pattern_ref(p);
+
+    m->comp = p->comp;
+    m->comp_len = p->comp_len;
+    m->pattern = p->pattern;
+
+    m->text = NULL;
+    m->text_len = 0u;
+    m->offs = 0u;
+    m->state = 0u;
+    m->hash = 0;
+
+    m->stream_offs = 0u;
+    m->window = NULL;
+
+#ifdef STRING_MATCH_STATS
+    memset(&m->stats, 0, sizeof(m->stats));
+#endif
+
+    return m;
+}
+
+void string_matcher_free(struct string_matcher *m)
+{
+    if (!m)
+        return;
+
+    string_pattern_free(m->compiled);
+
+    free(m->scan_state);
+    free(m->window);
+    free(m);
+}
+
+size_t string_matcher_reset(struct string_matcher *m, char const *text)
+{
+    return string_matcher_reset_n(m, text, strlen(text));
+}
+
+size_t string_matcher_reset_n(struct string_matcher *m,
+                              char const *text, size_t text_len)
+{
+    m->text = text;
+    m->text_len = text_len;
+    m->offs = 0u;
+    m->state = 0u;
+    m->hash = 0;
+
+    /* the automatic engine switches to another engine on reset */
+    m->ops = m->compiled->ops;
+    m->pattern = m->compiled->pattern;
+
+    if (m->comp_len > 0 && m->comp_len <= m->text_len && m->ops->reset)
+        m->ops->reset(m);
+
+    return m->text_len;
+}
+
+size_t string_matcher_next(struct string_matcher *m)
+{
+    if (!m->text || m->comp_len == 0 || m->comp_len > m->text_len)
+        return m->text_len;
+
+    size_t offs = m->ops->next(m);
+    STATS_ADD(m, matches, offs != m->text_len);
+
+    return offs;
+}
+
+size_t string_matcher_find_all(struct string_matcher *m,
+                               size_t *matches, size_t max_matches)
+{
+    if (!m->text || m->comp_len == 0 || m->comp_len > m->text_len)
+        return 0u;
+
+    size_t n = 0u;
+
+    if (m->ops->find_all) {
+        n = m->ops->find_all(m, matches, max_matches);
+    } else {
+        while (n < max_matches) {
+            size_t offs = m->ops->next(m);
+            if (offs == m->text_len)
+                break;
+
+            matches[n++] = offs;
+        }
+    }
+
+    STATS_ADD(m, matches, n);
+
+    return n;
+}
+
+size_t string_matcher_count(struct string_matcher *m)
+{
+    size_t matches[256];
+
+    size_t count = 0u;
+    for (;;) {
+        size_t n = string_matcher_find_all(m, matches, 256u);
+        count += n;
+
+        if (n < 256u)
+            return count;
+    }
+}
+
+int string_matcher_get_stats(struct string_matcher const *m,
+                             struct string_matcher_stats *stats)
+{
+#ifdef STRING_MATCH_STATS
+    *stats = m->stats;
+
+    stats->compile_ns = m->compiled->compile_ns;
+    stats->table_bytes = 0u;
+    stats->dfa_states = 0u;
+    stats->dfa_transitions = 0u;
+
+    if (m->pattern && m->ops->pattern_stats)
+        m->ops->pattern_stats(m->pattern, m->comp_len, stats);
+
+    return 1;
+#else
+    memset(stats, 0, sizeof(*stats));
+
+    return 0;
+#endif
+}
+
+
+/* reentrant multi pattern matchers */
+
+static struct string_multi_matcher_ops const *multi_engine_ops(
+    enum string_multi_match_engine engine)
+{
+    switch (engine) {
+    case STRING_MULTI_MATCH_AHO_CORASICK:
+        return &string_multi_match_aho_corasick_ops;
+    case STRING_MULTI_MATCH_RABIN_KARP:
+        return &string_multi_match_rabin_karp_ops;
+    }
+
+    return NULL;
+}
+
+struct string_multi_matcher * string_multi_matcher_create(
+    enum string_multi_match_engine engine, char const * const *comps,
+    size_t n_comps)
+{
+    if (!comps && n_comps > 0)
+        return NULL;
+
+    size_t *comp_lens = malloc((n_comps ? n_comps : 1) * sizeof(size_t));
+    if (!comp_lens)
+        return NULL;
+
+    for (size_t i = 0u; i < n_comps; ++i)
+        comp_lens[i] = strlen(comps[i]);
+
+    struct string_multi_matcher *m =
+        string_multi_matcher_create_n(engine, comps, comp_lens, n_comps);
+
+    free(comp_lens);
+
+    return m;
+}
+
+struct string_multi_matcher * string_multi_matcher_create_n(
+    enum string_multi_match_engine engine, char const * const *comps,
+    size_t const *comp_lens, size_t n_comps)
+{
+    struct string_multi_matcher_ops const *ops = multi_engine_ops(engine);
+    if (!ops || (!comps && n_comps > 0))
+        return NULL;
+
+    struct string_multi_matcher *m =
+        malloc(sizeof(struct string_multi_matcher));
+    if (!m)
+        return NULL;
+
+    m->ops = ops;
+
+    m->n_comps = n_comps;
+    m->comp_lens = malloc((n_comps ? n_comps : 1) * sizeof(size_t));
+    if (!m->comp_lens) {
+        free(m);
+        return NULL;
+    }
+
+    for (size_t i = 0u; i < n_comps; ++i)
+        m->comp_lens[i] = comp_lens[i];
+
+    m->pattern = ops->compile(comps, m->comp_lens, n_comps);
+    if (!m->pattern) {
+        free(m->comp_lens);
+        free(m);
+        return NULL;
+    }
+
+    m->scan_state = NULL;
+    size_t state_size = ops->state_size ? ops->state_size(m->pattern) : 0u;
+    if (state_size > 0u) {
+        m->scan_state = malloc(state_size);
+        if (!m->scan_state) {
+            ops->free(m->pattern);
+            free(m->comp_lens);
+            free(m);
+            return NULL;
+        }
+    }
+
+    m->text = NULL;
+    m->text_len = 0u;
+    m->offs = 0u;
+    m->state = 0u;
+    m->out_state = 0u;
+    m->out_id = 0u;
+
+    return m;
+}
+
+void string_multi_matcher_free(struct string_multi_matcher *m)
+{
+    if (!m)
+        return;
+
+    m->ops->free(m->pattern);
+
+    free(m->scan_state);
+    free(m->comp_lens);
+    free(m);
+}
+
+size_t string_multi_matcher_reset(struct string_multi_matcher *m,
+                                  char const *text)
+{
+    return string_multi_matcher_reset_n(m, text, strlen(text));
+}
+
+size_t string_multi_matcher_reset_n(struct string_multi_matcher *m,
+                                    char const *text, size_t text_len)
+{
+    m->text = text;
+    m->text_len = text_len;
+    m->offs = 0u;
+    m->state = 0u;
+    m->out_state = 0u;
+    m->out_id = 0u;
+
+    if (m->ops->reset)
+        m->ops->reset(m);
+
+    return m->text_len;
+}
+
+size_t string_multi_matcher_next(struct string_multi_matcher *m,
+                                 size_t *comp_id)
+{
+    if (!m->text)
+        return m->text_len;
+
+    return m->ops->next(m, comp_id);
+}
+
+
+/* static state wrapper */
+
+size_t string_match_static(struct string_match_static *s,
+                           enum string_match_engine engine,
+                           char const *text, char const *comp)
+{
+    if (!comp)
+        return string_match_static_n(s, engine, text, strlen(text), NULL, 0u);
+
+    /* the pattern length is only needed once per text */
+    size_t comp_len = s->init ? strlen(comp) : 0u;
+
+    return string_match_static_n(s, engine, text, s->text_len, comp, comp_len);
+}
+
+size_t string_match_static_n(struct string_match_static *s,
+                             enum string_match_engine engine,
+                             char const *text, size_t text_len,
+                             char const *comp, size_t comp_len)
+{
+    if (!comp) {
+        s->init = 1;
+        s->text = text;
+        s->text_len = text_len;
+        return s->text_len;
+    }
+
+    if (s->init) {
+        s->init = 0;
+
+        string_matcher_free(s->m);
+
+        s->m = string_matcher_create_n(engine, comp, comp_len);
+        if (s->m)
+            string_matcher_reset_n(s->m, s->text, s->text_len);
+    }
+
+    if (!s->m)
+        return s->text_len;
+
+    return string_matcher_next(s->m);
+}
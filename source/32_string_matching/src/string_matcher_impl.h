@@ -0,0 +1,198 @@
+#ifndef STRING_MATCHER_IMPL_H
+#define STRING_MATCHER_IMPL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "string_matching.h"
+
+
+/* engine interface */
+
+struct string_matcher;
+
+struct string_matcher_ops {
+    /* preprocess pattern, may be NULL if no preprocessing is needed */
+    void * (*compile)(char const *comp, size_t comp_len);
+    void (*free)(void *pattern);
+
+    /* optional, size of m->scan_state that is allocated per matcher */
+    size_t (*state_size)(void const *pattern);
+
+    /* optional, called after the matcher has been pointed at a new text */
+    void (*reset)(struct string_matcher *m);
+
+    /* return offset of next match or m->text_len if there is none, the
+       caller guarantees that 0 < m->comp_len <= m->text_len */
+    size_t (*next)(struct string_matcher *m);
+
+    /* optional, store the offsets of up to max_matches next matches in
+       matches and return their number, under the same guarantees as next */
+    size_t (*find_all)(struct string_matcher *m,
+                       size_t *matches, size_t max_matches);
+
+    /* optional, like next but m->text is only one chunk of a stream and the
+       scan state carries over between chunks, returns nonzero if a match
+       ending right before m->offs has been found, zero if the chunk has been
+       consumed */
+    int (*stream_next)(struct string_matcher *m);
+
+    /* optional, store the pattern properties of stats */
+    void (*pattern_stats)(void const *pattern, size_t comp_len,
+                          struct string_matcher_stats *stats);
+};
+
+extern struct string_matcher_ops const string_match_naive_ops;
+extern struct string_matcher_ops const string_match_rabin_karp_ops;
+extern struct string_matcher_ops const string_match_dfa_ops;
+extern struct string_matcher_ops const string_match_kmp_ops;
+extern struct string_matcher_ops const string_match_boyer_moore_ops;
+extern struct string_matcher_ops const string_match_two_way_ops;
+extern struct string_matcher_ops const string_match_shift_or_ops;
+extern struct string_matcher_ops const string_match_bndm_ops;
+extern struct string_matcher_ops const string_match_auto_ops;
+
+/* like string_match_naive_ops.next but gives up once the characters compared
+   while verifying candidates are no longer linear in the text characters
+   scanned, returns (size_t) -1 then and leaves m->offs at the first offset
+   that has not been examined, m->state holds the characters compared */
+size_t string_match_naive_next_bounded(struct string_matcher *m);
+
+
+/* compiled pattern, immutable after compilation except for refs */
+
+struct string_pattern {
+    struct string_matcher_ops const *ops;
+    enum string_match_engine engine;
+
+    char *comp;
+    size_t comp_len;
+    void *pattern;
+
+    size_t refs; /* accessed atomically */
+
+#ifdef STRING_MATCH_STATS
+    size_t compile_ns;
+#endif
+};
+
+struct string_pattern * string_pattern_ref(struct string_pattern *p);
+
+/* create a compiled pattern from an already preprocessed pattern, for
+   patterns that need more than ops->compile, pattern is owned by the
+   compiled pattern afterwards, also on failure */
+struct string_pattern * string_pattern_create(
+    struct string_matcher_ops const *ops, enum string_match_engine engine,
+    char const *comp, size_t comp_len, void *pattern);
+
+
+/* matcher state */
+
+struct string_matcher {
+    struct string_matcher_ops const *ops;
+    struct string_pattern *compiled;
+
+    /* borrowed from compiled */
+    char const *comp;
+    size_t comp_len;
+    void const *pattern;
+
+    char const *text;
+    size_t text_len;
+
+    size_t offs;   /* next text offset to be examined */
+    size_t state;  /* engine specific scan state */
+    uint64_t hash; /* engine specific rolling hash */
+
+    void *scan_state; /* engine specific, see state_size */
+
+    size_t stream_offs; /* stream offset of text when streaming */
+    char *window;       /* last comp_len stream characters if needed */
+
+#ifdef STRING_MATCH_STATS
+    struct string_matcher_stats stats;
+#endif
+};
+
+/* count scan events in m->stats, compiles to nothing (without evaluating its
+   arguments) unless STRING_MATCH_STATS is defined */
+#ifdef STRING_MATCH_STATS
+#define STATS_ADD(m, counter, n) ((m)->stats.counter += (n))
+#else
+#define STATS_ADD(m, counter, n) ((void) 0)
+#endif
+
+
+/* multi pattern engine interface */
+
+struct string_multi_matcher;
+
+struct string_multi_matcher_ops {
+    void * (*compile)(char const * const *comps, size_t const *comp_lens,
+                      size_t n_comps);
+    void (*free)(void *pattern);
+
+    /* optional, size of m->scan_state that is allocated per matcher */
+    size_t (*state_size)(void const *pattern);
+
+    /* optional, called after the matcher has been pointed at a new text */
+    void (*reset)(struct string_multi_matcher *m);
+
+    /* return start offset of next match and store the index of the matching
+       pattern in comp_id or return m->text_len if there is none */
+    size_t (*next)(struct string_multi_matcher *m, size_t *comp_id);
+};
+
+extern struct string_multi_matcher_ops const
+    string_multi_match_aho_corasick_ops;
+extern struct string_multi_matcher_ops const string_multi_match_rabin_karp_ops;
+
+
+/* multi pattern matcher state */
+
+struct string_multi_matcher {
+    struct string_multi_matcher_ops const *ops;
+
+    size_t n_comps;
+    size_t *comp_lens;
+    void *pattern;
+
+    char const *text;
+    size_t text_len;
+
+    size_t offs;      /* next text offset to be examined */
+    size_t state;     /* engine specific scan state */
+    size_t out_state; /* engine specific pending output */
+    size_t out_id;
+
+    void *scan_state; /* engine specific, see state_size */
+};
+
+
+/* suffix array construction */
+
+/* store the suffix array of text including the empty suffix in sa, which
+   needs room for text_len + 1 entries, returns zero on allocation failure */
+int string_index_suffix_array(unsigned char const *text, size_t text_len,
+                              size_t *sa);
+
+
+/* static state wrapper */
+
+struct string_match_static {
+    int init;
+    char const *text;
+    size_t text_len;
+    struct string_matcher *m;
+};
+
+size_t string_match_static(struct string_match_static *s,
+                           enum string_match_engine engine,
+                           char const *text, char const *comp);
+
+size_t string_match_static_n(struct string_match_static *s,
+                             enum string_match_engine engine,
+                             char const *text, size_t text_len,
+                             char const *comp, size_t comp_len);
+
+#endif
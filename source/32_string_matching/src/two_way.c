@@ -0,0 +1,211 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_matching.h"
+#include "string_matcher_impl.h"
+
+/* Crochemore-Perrin Two-Way matching. The pattern is split at a critical
+   factorization comp = u v, every window is compared against v from left to
+   right and then against u from right to left. The shift after a mismatch
+   follows from the period of the pattern, which makes the search linear
+   without any per pattern tables. A table holding the distance of every
+   character to the end of the pattern is used to skip windows whose last
+   character does not match, like the Boyer-Moore bad character rule, it has
+   a fixed size independent of the pattern length. */
+
+struct two_way_pattern {
+    size_t suffix;   /* start of v */
+    size_t period;
+    int periodic;    /* period is a period of the whole pattern */
+    size_t shift[256];
+};
+
+static size_t maximal_suffix(unsigned char const *comp, size_t comp_len,
+                             int reverse, size_t *period)
+{
+    /* start of the lexicographically maximal suffix of comp, minus one, and
+       its period, with the alphabet order reversed if reverse is set */
+    size_t max_suffix = SIZE_MAX;
+    size_t j = 0;
+    size_t k = 1;
+    size_t p = 1;
+
+    while (j + k < comp_len) {
+        unsigned char a = comp[j + k];
+        unsigned char b = comp[max_suffix + k];
+
+        if (reverse ? a > b : a < b) {
+            j += k;
+            k = 1;
+            p = j - max_suffix;
+        } else if (a == b) {
+            if (k != p) {
+                ++k;
+            } else {
+                j += p;
+                k = 1;
+            }
+        } else {
+            max_suffix = j++;
+            k = p = 1;
+        }
+    }
+
+    *period = p;
+
+    return max_suffix;
+}
+
+static size_t critical_factorization(unsigned char const *comp,
+                                     size_t comp_len, size_t *period)
+{
+    if (comp_len < 3) {
+        *period = 1;
+        return comp_len - 1;
+    }
+
+    size_t p, p_rev;
+    size_t max_suffix = maximal_suffix(comp, comp_len, 0, &p);
+    size_t max_suffix_rev = maximal_suffix(comp, comp_len, 1, &p_rev);
+
+    /* the later of both maximal suffixes yields a critical factorization */
+    if (max_suffix_rev + 1 < max_suffix + 1) {
+        *period = p;
+        return max_suffix + 1;
+    }
+
+    *period = p_rev;
+    return max_suffix_rev + 1;
+}
+
+static void * two_way_compile(char const *comp, size_t comp_len)
+{
+    unsigned char const *pattern = (unsigned char const *) comp;
+
+    struct two_way_pattern *p = malloc(sizeof(struct two_way_pattern));
+    if (!p)
+        return NULL;
+
+    p->suffix = critical_factorization(pattern, comp_len, &p->period);
+    p->periodic = memcmp(pattern, pattern + p->period, p->suffix) == 0;
+
+    /* otherwise occurrences are more than max(|u|, |v|) characters apart */
+    if (!p->periodic) {
+        size_t u = p->suffix;
+        size_t v = comp_len - p->suffix;
+        p->period = (u > v ? u : v) + 1;
+    }
+
+    for (size_t c = 0; c < 256; ++c)
+        p->shift[c] = comp_len;
+    for (size_t i = 0; i < comp_len; ++i)
+        p->shift[pattern[i]] = comp_len - 1 - i;
+
+    return p;
+}
+
+static size_t two_way_find_all(struct string_matcher *m,
+                               size_t *matches, size_t max_matches)
+{
+    struct two_way_pattern const *p = m->pattern;
+
+    unsigned char const *text = (unsigned char const *) m->text;
+    unsigned char const *pattern = (unsigned char const *) m->comp;
+    size_t const comp_len = m->comp_len;
+    size_t const last_shift = m->text_len - comp_len;
+    size_t const suffix = p->suffix;
+    size_t const period = p->period;
+
+    /* m->offs is the current window, m->state the length of the pattern
+       prefix known to match it from a previous periodic shift */
+    size_t j = m->offs;
+    size_t memory = m->state;
+    size_t n = 0;
+
+    while (j <= last_shift && n < max_matches) {
+        size_t shift = p->shift[text[j + comp_len - 1]];
+        STATS_ADD(m, chars_compared, 1u);
+
+        if (shift > 0) {
+            /* a periodic pattern can not match before the mismatch if the
+               previous window matched up to its last period */
+            if (memory && shift < period)
+                shift = comp_len - period;
+
+            memory = 0;
+            j += shift;
+            continue;
+        }
+
+        /* the last character is known to match */
+        size_t i = suffix > memory ? suffix : memory;
+        while (i < comp_len - 1 && pattern[i] == text[j + i])
+            ++i;
+
+        STATS_ADD(m, chars_compared, i - (suffix > memory ? suffix : memory) +
+                                     (i < comp_len - 1));
+
+        if (i < comp_len - 1) {
+            j += i - suffix + 1;
+            memory = 0;
+            continue;
+        }
+
+        i = suffix;
+        while (i > memory && pattern[i - 1] == text[j + i - 1])
+            --i;
+
+        STATS_ADD(m, chars_compared, suffix - i + (i > memory));
+
+        if (i <= memory)
+            matches[n++] = j;
+
+        j += period;
+        memory = p->periodic ? comp_len - period : 0;
+    }
+
+    m->offs = j;
+    m->state = memory;
+
+    return n;
+}
+
+static size_t two_way_next(struct string_matcher *m)
+{
+    size_t offs;
+
+    return two_way_find_all(m, &offs, 1) ? offs : m->text_len;
+}
+
+static void two_way_pattern_stats(void const *pattern, size_t comp_len,
+                                  struct string_matcher_stats *stats)
+{
+    stats->table_bytes = sizeof(struct two_way_pattern);
+}
+
+struct string_matcher_ops const string_match_two_way_ops = {
+    .compile = two_way_compile,
+    .free = free,
+    .state_size = NULL,
+    .reset = NULL,
+    .next = two_way_next,
+    .find_all = two_way_find_all,
+    .stream_next = NULL,
+    .pattern_stats = two_way_pattern_stats
+};
+
+static struct string_match_static two_way_static;
+
+size_t string_match_two_way(char const *text, char const *comp)
+{
+    return string_match_static(&two_way_static, STRING_MATCH_TWO_WAY,
+                               text, comp);
+}
+
+size_t string_match_two_way_n(char const *text, size_t text_len,
+                              char const *comp, size_t comp_len)
+{
+    return string_match_static_n(&two_way_static, STRING_MATCH_TWO_WAY,
+                                 text, text_len, comp, comp_len);
+}
@@ -1,7 +1,16 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
+#include <random>
+#include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
+#include <unistd.h>
+
 #include "gtest/gtest.h"
 
 extern "C" {
@@ -12,14 +21,12 @@ using ::testing::TestWithParam;
 using ::testing::Values;
 
 
-class StringMatchTest
-    : public TestWithParam<std::function<std::size_t(char const*, char const*)>>
-{
+namespace {
+
 using test_input_type =
     std::tuple<char const *, char const *, std::vector<size_t>>;
 
-protected:
-    std::vector<test_input_type> test_inputs {
+std::vector<test_input_type> const test_inputs {
         std::make_tuple("abcabaabcabac", "abcabaabcabac",
                         std::vector<std::size_t>({0})),
         std::make_tuple("abcabaabcabac", "abaa",
@@ -32,11 +39,20 @@ protected:
                         std::vector<std::size_t>({0, 1, 2})),
         std::make_tuple("aaaababa", "ba",
                         std::vector<std::size_t>({4, 6})),
+        std::make_tuple("aaaa", "aaa",
+                        std::vector<std::size_t>({0, 1})),
         std::make_tuple("abc", "ba",
+                        std::vector<std::size_t>({})),
+        std::make_tuple("ab", "abc",
                         std::vector<std::size_t>({}))
-    };
 };
 
+} // namespace
+
+class StringMatchTest
+    : public TestWithParam<std::function<std::size_t(char const*, char const*)>>
+{};
+
 TEST_P(StringMatchTest, CanMatchPatterns)
 {
     auto match = GetParam();
@@ -65,4 +81,1068 @@ INSTANTIATE_TEST_CASE_P(StringMatchAlgorithms, StringMatchTest, Values(
     string_match_naive,
     string_match_rabin_karp,
     string_match_dfa,
-    string_match_kmp));
+    string_match_kmp,
+    string_match_boyer_moore,
+    string_match_two_way,
+    string_match_shift_or,
+    string_match_bndm,
+    string_match));
+
+class StringMatchLengthTest
+    : public TestWithParam<std::function<std::size_t(char const*, std::size_t,
+                                                     char const*, std::size_t)>>
+{};
+
+TEST_P(StringMatchLengthTest, CanMatchBinaryPatterns)
+{
+    auto match = GetParam();
+
+    /* embedded NUL and non ASCII characters, text is a slice of a buffer */
+    std::string buffer("xx\0\x80\xff\0\x80\0\x80\xff\x80\0yy", 14);
+    std::string comp("\0\x80\xff", 3);
+
+    char const *text = buffer.data() + 2;
+    std::size_t text_len = buffer.size() - 4u;
+
+    std::vector<std::size_t> expected({0, 5});
+    std::vector<std::size_t> result;
+
+    std::size_t end_of_text = match(text, text_len, nullptr, 0u);
+    EXPECT_EQ(text_len, end_of_text)
+        << "string matching algorithm returns end of text on reset";
+
+    for (std::size_t i = 0u; i < expected.size(); ++i)
+        result.push_back(match(text, text_len, comp.data(), comp.size()));
+
+    EXPECT_EQ(end_of_text, match(text, text_len, comp.data(), comp.size()))
+        << "string matching algorithm returns end of text after all matches have been found";
+
+    EXPECT_EQ(expected, result)
+        << "string matching algorithm produces correct output for binary data";
+}
+
+INSTANTIATE_TEST_CASE_P(StringMatchAlgorithms, StringMatchLengthTest, Values(
+    string_match_naive_n,
+    string_match_rabin_karp_n,
+    string_match_dfa_n,
+    string_match_kmp_n,
+    string_match_boyer_moore_n,
+    string_match_two_way_n,
+    string_match_shift_or_n,
+    string_match_bndm_n,
+    string_match_n));
+
+class StringMatcherTest : public TestWithParam<string_match_engine>
+{};
+
+TEST_P(StringMatcherTest, CanMatchPatternsConcurrently)
+{
+    auto engine = GetParam();
+
+    std::vector<struct string_matcher *> matchers;
+    std::vector<std::vector<size_t>> results(test_inputs.size());
+
+    for (auto const &test_input : test_inputs) {
+        auto m = string_matcher_create(engine, std::get<1>(test_input));
+        ASSERT_NE(m, nullptr)
+            << "string matcher can be created";
+
+        EXPECT_EQ(std::strlen(std::get<0>(test_input)),
+                  string_matcher_reset(m, std::get<0>(test_input)))
+            << "string matcher reset returns end of text";
+
+        matchers.push_back(m);
+    }
+
+    /* advance all matchers in lockstep to make sure they don't share state */
+    for (bool done = false; !done;) {
+        done = true;
+
+        for (std::size_t i = 0u; i < matchers.size(); ++i) {
+            std::size_t end_of_text = std::strlen(std::get<0>(test_inputs[i]));
+            if (results[i].size() > std::get<2>(test_inputs[i]).size())
+                continue;
+
+            results[i].push_back(string_matcher_next(matchers[i]));
+
+            if (results[i].back() != end_of_text)
+                done = false;
+        }
+    }
+
+    for (std::size_t i = 0u; i < matchers.size(); ++i) {
+        std::size_t end_of_text = std::strlen(std::get<0>(test_inputs[i]));
+
+        std::vector<size_t> expected = std::get<2>(test_inputs[i]);
+        expected.push_back(end_of_text);
+
+        EXPECT_EQ(expected, results[i])
+            << "interleaved string matchers produce correct output";
+
+        string_matcher_free(matchers[i]);
+    }
+}
+
+TEST_P(StringMatcherTest, CanMatchRandomPatterns)
+{
+    auto engine = GetParam();
+
+    std::mt19937 gen(42u);
+
+    for (int alphabet : {2, 4, 26}) {
+        std::uniform_int_distribution<int> dist(0, alphabet - 1);
+
+        auto random_string = [&](std::size_t len) {
+            std::string s;
+            for (std::size_t i = 0u; i < len; ++i)
+                s.push_back(static_cast<char>('a' + dist(gen)));
+            return s;
+        };
+
+        for (int i = 0; i < 50; ++i) {
+            std::string text = random_string(500u);
+            std::string comp = random_string(1u + i % 12);
+
+            std::vector<std::size_t> expected;
+            for (auto pos = text.find(comp);
+                 pos != std::string::npos;
+                 pos = text.find(comp, pos + 1u)) {
+                expected.push_back(pos);
+            }
+
+            auto m = string_matcher_create(engine, comp.c_str());
+            ASSERT_NE(m, nullptr)
+                << "string matcher can be created";
+
+            std::size_t end_of_text = string_matcher_reset(m, text.c_str());
+
+            std::vector<std::size_t> result;
+            for (auto pos = string_matcher_next(m);
+                 pos != end_of_text;
+                 pos = string_matcher_next(m)) {
+                result.push_back(pos);
+            }
+
+            EXPECT_EQ(expected, result)
+                << "string matcher finds all occurrences of '" << comp << "'";
+
+            string_matcher_free(m);
+        }
+    }
+}
+
+TEST_P(StringMatcherTest, CanMatchRandomBinaryPatterns)
+{
+    auto engine = GetParam();
+
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist(0, 3);
+
+    char const alphabet[] = {'\0', 'a', '\x80', '\xff'};
+
+    auto random_string = [&](std::size_t len) {
+        std::string s;
+        for (std::size_t i = 0u; i < len; ++i)
+            s.push_back(alphabet[dist(gen)]);
+        return s;
+    };
+
+    for (int i = 0; i < 50; ++i) {
+        std::string text = random_string(500u);
+        std::string comp = random_string(1u + i % 8);
+
+        std::vector<std::size_t> expected;
+        for (auto pos = text.find(comp);
+             pos != std::string::npos;
+             pos = text.find(comp, pos + 1u)) {
+            expected.push_back(pos);
+        }
+
+        auto m = string_matcher_create_n(engine, comp.data(), comp.size());
+        ASSERT_NE(m, nullptr)
+            << "string matcher can be created";
+
+        std::size_t end_of_text =
+            string_matcher_reset_n(m, text.data(), text.size());
+
+        std::vector<std::size_t> result;
+        for (auto pos = string_matcher_next(m);
+             pos != end_of_text;
+             pos = string_matcher_next(m)) {
+            result.push_back(pos);
+        }
+
+        EXPECT_EQ(expected, result)
+            << "string matcher finds all occurrences in binary data";
+
+        string_matcher_free(m);
+    }
+}
+
+TEST_P(StringMatcherTest, CanMatchLongPatterns)
+{
+    auto engine = GetParam();
+
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist(0, 19);
+
+    /* mostly periodic text so that long patterns occur repeatedly */
+    std::string text;
+    for (std::size_t i = 0u; i < 5000u; ++i)
+        text.push_back(dist(gen) == 0 ? 'b' : "aab"[i % 3]);
+
+    for (std::size_t comp_len : {63u, 64u, 65u, 100u, 300u}) {
+        std::string comp = text.substr(1000u, comp_len);
+
+        std::vector<std::size_t> expected;
+        for (auto pos = text.find(comp);
+             pos != std::string::npos;
+             pos = text.find(comp, pos + 1u)) {
+            expected.push_back(pos);
+        }
+
+        auto m = string_matcher_create_n(engine, comp.data(), comp.size());
+        ASSERT_NE(m, nullptr)
+            << "string matcher can be created";
+
+        string_matcher_reset_n(m, text.data(), text.size());
+
+        std::vector<std::size_t> result(expected.size() + 1u);
+        result.resize(string_matcher_find_all(m, result.data(), result.size()));
+
+        EXPECT_EQ(expected, result)
+            << "string matcher finds all occurrences of pattern of length "
+            << comp_len;
+
+        string_matcher_free(m);
+    }
+}
+
+TEST_P(StringMatcherTest, CanFindAllMatches)
+{
+    auto engine = GetParam();
+
+    for (auto const &test_input : test_inputs) {
+        char const *text = std::get<0>(test_input);
+        char const *comp = std::get<1>(test_input);
+
+        std::vector<size_t> expected = std::get<2>(test_input);
+
+        auto m = string_matcher_create(engine, comp);
+        ASSERT_NE(m, nullptr)
+            << "string matcher can be created";
+
+        /* resume after every single match */
+        string_matcher_reset(m, text);
+
+        std::vector<size_t> result;
+
+        std::size_t offs;
+        while (string_matcher_find_all(m, &offs, 1u) == 1u)
+            result.push_back(offs);
+
+        EXPECT_EQ(expected, result)
+            << "string matcher finds all matches with capacity one";
+
+        /* mix find all with next */
+        std::size_t end_of_text = string_matcher_reset(m, text);
+
+        result.resize(expected.size() + 1u);
+        std::size_t n = string_matcher_find_all(m, result.data(), 1u);
+        if (n == 1u) {
+            n += string_matcher_find_all(m, result.data() + 1u,
+                                         result.size() - 1u);
+        }
+        result.resize(n);
+
+        EXPECT_EQ(expected, result)
+            << "string matcher finds all matches with sufficient capacity";
+
+        EXPECT_EQ(end_of_text, string_matcher_next(m))
+            << "string matcher is exhausted after find all";
+
+        string_matcher_reset(m, text);
+        EXPECT_EQ(expected.size(), string_matcher_count(m))
+            << "string matcher counts all matches";
+
+        string_matcher_free(m);
+    }
+}
+
+TEST_P(StringMatcherTest, CanShareCompiledPatterns)
+{
+    auto engine = GetParam();
+
+    for (auto const &test_input : test_inputs) {
+        char const *text = std::get<0>(test_input);
+
+        auto p = string_pattern_compile(engine, std::get<1>(test_input));
+        ASSERT_NE(p, nullptr)
+            << "pattern can be compiled";
+
+        auto m1 = string_matcher_create_from_pattern(p);
+        auto m2 = string_matcher_create_from_pattern(p);
+        ASSERT_TRUE(m1 != nullptr && m2 != nullptr)
+            << "string matchers can be created from compiled pattern";
+
+        /* matchers keep the pattern alive */
+        string_pattern_free(p);
+
+        std::size_t end_of_text = string_matcher_reset(m1, text);
+        string_matcher_reset(m2, text);
+
+        std::vector<std::size_t> result1, result2;
+
+        for (auto pos = string_matcher_next(m1);
+             pos != end_of_text;
+             pos = string_matcher_next(m1)) {
+            result1.push_back(pos);
+            result2.push_back(string_matcher_next(m2));
+        }
+
+        EXPECT_EQ(std::get<2>(test_input), result1)
+            << "string matcher using compiled pattern produces correct output";
+
+        EXPECT_EQ(std::get<2>(test_input), result2)
+            << "string matchers sharing compiled pattern are independent";
+
+        string_matcher_free(m1);
+        string_matcher_free(m2);
+    }
+}
+
+TEST_P(StringMatcherTest, CanCachePatterns)
+{
+    auto engine = GetParam();
+
+    auto c = string_pattern_cache_create(2u);
+    ASSERT_NE(c, nullptr)
+        << "pattern cache can be created";
+
+    auto get = [&](char const *comp) {
+        return string_pattern_cache_get(c, engine, comp, std::strlen(comp));
+    };
+
+    auto abc = get("abc");
+    auto bcd = get("bcd");
+    ASSERT_TRUE(abc != nullptr && bcd != nullptr)
+        << "patterns can be compiled through cache";
+
+    auto abc_again = get("abc");
+    EXPECT_EQ(abc, abc_again)
+        << "cached pattern is reused";
+
+    /* "bcd" is now the least recently used pattern */
+    auto cde = get("cde");
+    auto abc_cached = get("abc");
+    auto bcd_evicted = get("bcd");
+
+    EXPECT_EQ(abc, abc_cached)
+        << "recently used pattern is not evicted";
+
+    EXPECT_NE(bcd, bcd_evicted)
+        << "least recently used pattern is evicted";
+
+    auto m = string_matcher_create_from_pattern(bcd_evicted);
+    string_matcher_reset(m, "abcdbcd");
+    EXPECT_EQ(2u, string_matcher_count(m))
+        << "cached pattern can be used for matching";
+
+    for (auto p : {abc, bcd, abc_again, cde, abc_cached, bcd_evicted})
+        string_pattern_free(p);
+
+    string_matcher_free(m);
+    string_pattern_cache_free(c);
+}
+
+TEST_P(StringMatcherTest, CanMatchPatternsInParallel)
+{
+    auto engine = GetParam();
+
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist(0, 1);
+
+    std::string text;
+    for (std::size_t i = 0u; i < 1000000u; ++i)
+        text.push_back(static_cast<char>('a' + dist(gen)));
+
+    for (char const *comp : {"a", "abbabbaab", "aaaaaaaaaaaaaaaaaaaaab"}) {
+        std::vector<std::size_t> expected;
+        for (auto pos = text.find(comp);
+             pos != std::string::npos;
+             pos = text.find(comp, pos + 1u)) {
+            expected.push_back(pos);
+        }
+
+        for (std::size_t n_threads : {1u, 3u, 8u}) {
+            std::size_t *matches;
+            std::size_t n_matches = string_match_parallel(
+                engine, text.c_str(), comp, n_threads, &matches);
+
+            ASSERT_EQ(expected.size(), n_matches)
+                << "parallel search finds correct number of matches";
+
+            EXPECT_TRUE(std::equal(expected.begin(), expected.end(), matches))
+                << "parallel search returns ordered matches";
+
+            std::free(matches);
+        }
+    }
+}
+
+TEST_P(StringMatcherTest, CanMatchStreams)
+{
+    auto engine = GetParam();
+
+    if (engine != STRING_MATCH_KMP &&
+        engine != STRING_MATCH_DFA &&
+        engine != STRING_MATCH_RABIN_KARP) {
+
+        EXPECT_EQ(string_stream_matcher_create(engine, "a"), nullptr)
+            << "stream matcher can not be created for unsupported engine";
+        return;
+    }
+
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist(0, 2);
+    std::uniform_int_distribution<std::size_t> chunk_dist(0u, 17u);
+
+    std::string text;
+    for (std::size_t i = 0u; i < 5000u; ++i)
+        text.push_back(static_cast<char>('a' + dist(gen)));
+
+    for (char const *comp : {"a", "abca", "abcabcabc", "aabbccaabbccaabbcc"}) {
+        std::vector<std::size_t> expected;
+        for (auto pos = text.find(comp);
+             pos != std::string::npos;
+             pos = text.find(comp, pos + 1u)) {
+            expected.push_back(pos);
+        }
+
+        auto s = string_stream_matcher_create(engine, comp);
+        ASSERT_NE(s, nullptr)
+            << "stream matcher can be created";
+
+        std::vector<std::size_t> result;
+
+        for (std::size_t offs = 0u; offs < text.size();) {
+            std::size_t chunk_len =
+                std::min(chunk_dist(gen), text.size() - offs);
+
+            /* copy the chunk so that reading past it is detectable */
+            std::vector<char> chunk(text.begin() + offs,
+                                    text.begin() + offs + chunk_len);
+
+            std::size_t end_of_stream =
+                string_stream_matcher_feed(s, chunk.data(), chunk_len);
+
+            offs += chunk_len;
+            ASSERT_EQ(offs, end_of_stream)
+                << "stream matcher feed returns end of stream";
+
+            for (auto pos = string_stream_matcher_next(s);
+                 pos != end_of_stream;
+                 pos = string_stream_matcher_next(s)) {
+                result.push_back(pos);
+            }
+        }
+
+        EXPECT_EQ(expected, result)
+            << "stream matcher finds all occurrences across chunk boundaries";
+
+        string_stream_matcher_free(s);
+    }
+}
+
+TEST_P(StringMatcherTest, CanCollectStatistics)
+{
+    auto engine = GetParam();
+
+    auto m = string_matcher_create(engine, "abcab");
+    ASSERT_NE(m, nullptr);
+
+    string_matcher_reset(m, "abcabcabxabcababcab");
+    std::size_t n_matches = string_matcher_count(m);
+
+    string_matcher_stats stats;
+    if (!string_matcher_get_stats(m, &stats)) {
+        EXPECT_EQ(0u, stats.matches)
+            << "statistics are zero if they are not collected";
+        EXPECT_EQ(0u, stats.table_bytes)
+            << "statistics are zero if they are not collected";
+
+        string_matcher_free(m);
+        return;
+    }
+
+    EXPECT_EQ(n_matches, stats.matches)
+        << "statistics count matches";
+
+    EXPECT_GT(stats.chars_compared + stats.verifications + stats.hash_hits, 0u)
+        << "statistics count scanning work";
+
+    EXPECT_GT(stats.table_bytes, 0u)
+        << "statistics report the size of the compiled pattern";
+
+    if (engine == STRING_MATCH_RABIN_KARP) {
+        EXPECT_EQ(n_matches, stats.hash_hits - stats.hash_collisions)
+            << "hash hits are either matches or collisions";
+    }
+
+    if (engine == STRING_MATCH_KMP) {
+        EXPECT_GT(stats.failure_links, 0u)
+            << "statistics count failure links";
+    }
+
+    if (engine == STRING_MATCH_DFA) {
+        EXPECT_EQ(6u, stats.dfa_states)
+            << "statistics report the number of DFA states";
+        EXPECT_EQ(6u * 4u, stats.dfa_transitions)
+            << "statistics report the number of DFA transitions";
+    }
+
+    /* counters accumulate over texts */
+    string_matcher_reset(m, "abcab");
+    string_matcher_count(m);
+
+    string_matcher_stats more;
+    string_matcher_get_stats(m, &more);
+
+    EXPECT_EQ(n_matches + 1u, more.matches)
+        << "statistics accumulate over texts";
+
+    string_matcher_free(m);
+}
+
+TEST(StringMatcherStatsTest, CanCountNaiveVerification)
+{
+    /* every offset passes the first and last character filter */
+    std::string text(1000u, 'a');
+    std::string comp = std::string(32u, 'a') + 'b' + std::string(31u, 'a');
+
+    auto m = string_matcher_create_n(STRING_MATCH_NAIVE,
+                                     comp.data(), comp.size());
+    ASSERT_NE(m, nullptr);
+
+    string_matcher_reset_n(m, text.data(), text.size());
+    EXPECT_EQ(0u, string_matcher_count(m));
+
+    string_matcher_stats stats;
+    if (string_matcher_get_stats(m, &stats)) {
+        EXPECT_GE(stats.chars_compared,
+                  (text.size() - comp.size() + 1u) * 32u)
+            << "statistics count characters verified by naive";
+    }
+
+    string_matcher_free(m);
+}
+
+INSTANTIATE_TEST_CASE_P(StringMatchEngines, StringMatcherTest, Values(
+    STRING_MATCH_NAIVE,
+    STRING_MATCH_RABIN_KARP,
+    STRING_MATCH_DFA,
+    STRING_MATCH_KMP,
+    STRING_MATCH_BOYER_MOORE,
+    STRING_MATCH_TWO_WAY,
+    STRING_MATCH_SHIFT_OR,
+    STRING_MATCH_BNDM,
+    STRING_MATCH_AUTO));
+
+TEST(StringMatchAutoTest, CanSelectEngines)
+{
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    std::string periodic(4096u, 'a');
+
+    std::string dna;
+    for (std::size_t i = 0u; i < 4096u; ++i)
+        dna.push_back("ACGT"[dist(gen) % 4]);
+
+    std::string bytes;
+    for (std::size_t i = 0u; i < 4096u; ++i)
+        bytes.push_back(static_cast<char>(dist(gen)));
+
+    std::string english(
+        "it is a truth universally acknowledged, that a single man in "
+        "possession of a good fortune, must be in want of a wife.");
+
+    EXPECT_EQ(STRING_MATCH_SHIFT_OR,
+              string_match_select(periodic.data(), periodic.size(), "aaaa", 4u))
+        << "linear time engine is selected if naive would be quadratic";
+
+    EXPECT_EQ(STRING_MATCH_KMP,
+              string_match_select(periodic.data(), periodic.size(),
+                                  periodic.data(), 100u))
+        << "KMP is selected for long patterns if naive would be quadratic";
+
+    EXPECT_EQ(STRING_MATCH_SHIFT_OR,
+              string_match_select(nullptr, 0u, "aaaa", 4u))
+        << "pattern is used as sample if text is unknown";
+
+    EXPECT_EQ(STRING_MATCH_NAIVE,
+              string_match_select(english.data(), english.size(), "man", 3u))
+        << "naive is selected for natural language";
+
+    EXPECT_EQ(STRING_MATCH_NAIVE,
+              string_match_select(periodic.data(), 32u, "aaaa", 4u))
+        << "naive is selected for short texts";
+
+    EXPECT_EQ(STRING_MATCH_TWO_WAY,
+              string_match_select(bytes.data(), bytes.size(),
+                                  bytes.data() + 1000u, 256u))
+        << "Two-Way is selected for long patterns over large alphabets";
+
+    EXPECT_EQ(STRING_MATCH_BNDM,
+              string_match_select(dna.data(), dna.size(),
+                                  dna.data() + 1000u, 64u))
+        << "BNDM is selected for long patterns over small alphabets";
+}
+
+TEST(StringMatchAutoTest, CanSwitchEnginesOnReset)
+{
+    char const *comp = "aaba";
+
+    /* Shift-Or is selected for the first text and naive for the second one */
+    std::string periodic(4096u, 'a');
+    periodic[1000] = 'b';
+
+    std::string text;
+    for (int i = 0; i < 400; ++i)
+        text += "xyzaabaxyz";
+
+    ASSERT_EQ(STRING_MATCH_SHIFT_OR,
+              string_match_select(periodic.data(), periodic.size(), comp, 4u));
+    ASSERT_EQ(STRING_MATCH_NAIVE,
+              string_match_select(text.data(), text.size(), comp, 4u));
+
+    auto m = string_matcher_create(STRING_MATCH_AUTO, comp);
+    ASSERT_NE(m, nullptr)
+        << "automatic string matcher can be created";
+
+    for (auto const &t : {periodic, text, periodic, text}) {
+        std::vector<std::size_t> expected;
+        for (auto pos = t.find(comp);
+             pos != std::string::npos;
+             pos = t.find(comp, pos + 1u)) {
+            expected.push_back(pos);
+        }
+
+        std::size_t end_of_text = string_matcher_reset_n(m, t.data(), t.size());
+
+        std::vector<std::size_t> result;
+        for (auto pos = string_matcher_next(m);
+             pos != end_of_text;
+             pos = string_matcher_next(m)) {
+            result.push_back(pos);
+        }
+
+        EXPECT_EQ(expected, result)
+            << "automatic string matcher finds all occurrences";
+    }
+
+    string_matcher_free(m);
+}
+
+TEST(StringMatchAutoTest, CanBoundNaiveWork)
+{
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist('b', 'z');
+
+    std::string text;
+    for (std::size_t i = 0u; i < 3u * 1024u * 1024u; ++i)
+        text.push_back(static_cast<char>(dist(gen)));
+
+    /* a run of a in between the blocks sampled by string_match_select */
+    std::size_t const run_start = 1200000u;
+    std::size_t const run_len = 800000u;
+
+    std::fill(text.begin() + run_start,
+              text.begin() + run_start + run_len, 'a');
+
+    std::string comp = std::string(9999u, 'a') + 'b' + std::string(10000u, 'a');
+
+    ASSERT_EQ(STRING_MATCH_NAIVE,
+              string_match_select(text.data(), text.size(),
+                                  comp.data(), comp.size()))
+        << "naive is selected if the sample misses the run";
+
+    std::size_t const match = run_start + run_len / 2u;
+    text[match + 9999u] = 'b';
+
+    auto m = string_matcher_create_n(STRING_MATCH_AUTO,
+                                     comp.data(), comp.size());
+    ASSERT_NE(m, nullptr)
+        << "automatic string matcher can be created";
+
+    std::size_t end_of_text =
+        string_matcher_reset_n(m, text.data(), text.size());
+
+    EXPECT_EQ(match, string_matcher_next(m))
+        << "automatic string matcher finds match inside the run";
+
+    EXPECT_EQ(end_of_text, string_matcher_next(m))
+        << "automatic string matcher finds no further matches";
+
+    string_matcher_free(m);
+
+    /* every offset in the run matches a short pattern of a */
+    std::string short_comp(100u, 'a');
+
+    m = string_matcher_create_n(STRING_MATCH_AUTO,
+                                short_comp.data(), short_comp.size());
+    ASSERT_NE(m, nullptr)
+        << "automatic string matcher can be created";
+
+    string_matcher_reset_n(m, text.data(), text.size());
+
+    EXPECT_EQ(run_len - 1u - 2u * (short_comp.size() - 1u),
+              string_matcher_count(m))
+        << "automatic string matcher counts all matches inside the run";
+
+    string_matcher_free(m);
+}
+
+TEST(StringApproxMatcherTest, CanMatchWithMismatches)
+{
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist(0, 3);
+
+    std::string text;
+    for (std::size_t i = 0u; i < 2000u; ++i)
+        text.push_back(static_cast<char>('a' + dist(gen)));
+
+    for (std::size_t comp_len : {1u, 5u, 17u, 64u}) {
+        std::string comp = text.substr(500u, comp_len);
+
+        for (std::size_t k : {0u, 1u, 3u, 70u}) {
+            std::vector<std::size_t> expected;
+            for (std::size_t i = 0u; i + comp_len <= text.size(); ++i) {
+                std::size_t mismatches = 0u;
+                for (std::size_t j = 0u; j < comp_len; ++j)
+                    mismatches += text[i + j] != comp[j];
+
+                if (mismatches <= k)
+                    expected.push_back(i);
+            }
+
+            auto m = string_matcher_create_approx_n(comp.data(), comp_len, k);
+            ASSERT_NE(m, nullptr)
+                << "approximate string matcher can be created";
+
+            std::size_t end_of_text =
+                string_matcher_reset_n(m, text.data(), text.size());
+
+            std::vector<std::size_t> result;
+            for (auto pos = string_matcher_next(m);
+                 pos != end_of_text;
+                 pos = string_matcher_next(m)) {
+                result.push_back(pos);
+            }
+
+            EXPECT_EQ(expected, result)
+                << "approximate string matcher finds all windows with at most "
+                << k << " mismatches";
+
+            string_matcher_free(m);
+        }
+    }
+
+    EXPECT_EQ(string_matcher_create_approx_n(text.data(), 65u, 1u), nullptr)
+        << "approximate string matcher can not be created for long patterns";
+}
+
+class StringMultiMatcherTest : public TestWithParam<string_multi_match_engine>
+{};
+
+TEST_P(StringMultiMatcherTest, CanMatchMultiplePatterns)
+{
+    auto engine = GetParam();
+
+    std::vector<char const *> comps;
+    for (auto const &test_input : test_inputs)
+        comps.push_back(std::get<1>(test_input));
+
+    /* duplicate pattern and pattern that is a suffix of another one */
+    comps.push_back("abc");
+    comps.push_back("c");
+
+    auto m = string_multi_matcher_create(engine, comps.data(), comps.size());
+    ASSERT_NE(m, nullptr)
+        << "multi pattern matcher can be created";
+
+    for (auto const &test_input : test_inputs) {
+        std::string text(std::get<0>(test_input));
+
+        std::vector<std::pair<std::size_t, std::size_t>> expected;
+        for (std::size_t id = 0u; id < comps.size(); ++id) {
+            for (auto pos = text.find(comps[id]);
+                 pos != std::string::npos;
+                 pos = text.find(comps[id], pos + 1u)) {
+                expected.emplace_back(pos + std::strlen(comps[id]), id);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        std::size_t end_of_text = string_multi_matcher_reset(m, text.c_str());
+        EXPECT_EQ(text.size(), end_of_text)
+            << "multi pattern matcher reset returns end of text";
+
+        std::vector<std::pair<std::size_t, std::size_t>> result;
+
+        std::size_t id;
+        for (auto pos = string_multi_matcher_next(m, &id);
+             pos != end_of_text;
+             pos = string_multi_matcher_next(m, &id)) {
+            result.emplace_back(pos + std::strlen(comps[id]), id);
+        }
+
+        EXPECT_TRUE(std::is_sorted(result.begin(), result.end(),
+            [](std::pair<std::size_t, std::size_t> const &lhs,
+               std::pair<std::size_t, std::size_t> const &rhs) {
+                return lhs.first < rhs.first;
+            }))
+            << "multi pattern matches are reported in order of their end offset";
+
+        std::sort(result.begin(), result.end());
+
+        EXPECT_EQ(expected, result)
+            << "multi pattern matcher finds all occurrences of all patterns";
+
+        EXPECT_EQ(end_of_text, string_multi_matcher_next(m, &id))
+            << "multi pattern matcher returns end of text after all matches have been found";
+    }
+
+    string_multi_matcher_free(m);
+}
+
+TEST_P(StringMultiMatcherTest, CanMatchRandomPatterns)
+{
+    auto engine = GetParam();
+
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist(0, 3);
+
+    auto random_string = [&](std::size_t len) {
+        std::string s;
+        for (std::size_t i = 0u; i < len; ++i)
+            s.push_back(static_cast<char>('a' + dist(gen)));
+        return s;
+    };
+
+    for (int i = 0; i < 20; ++i) {
+        std::vector<std::string> comps;
+        for (int j = 0; j < 30; ++j)
+            comps.push_back(random_string(1u + (i + j) % 6));
+
+        std::vector<char const *> comp_ptrs;
+        for (auto const &comp : comps)
+            comp_ptrs.push_back(comp.c_str());
+
+        auto m = string_multi_matcher_create(engine, comp_ptrs.data(),
+                                             comp_ptrs.size());
+        ASSERT_NE(m, nullptr)
+            << "multi pattern matcher can be created";
+
+        std::string text = random_string(1000u);
+
+        std::vector<std::pair<std::size_t, std::size_t>> expected;
+        for (std::size_t id = 0u; id < comps.size(); ++id) {
+            for (auto pos = text.find(comps[id]);
+                 pos != std::string::npos;
+                 pos = text.find(comps[id], pos + 1u)) {
+                expected.emplace_back(pos, id);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        std::size_t end_of_text = string_multi_matcher_reset(m, text.c_str());
+
+        std::vector<std::pair<std::size_t, std::size_t>> result;
+
+        std::size_t id;
+        for (auto pos = string_multi_matcher_next(m, &id);
+             pos != end_of_text;
+             pos = string_multi_matcher_next(m, &id)) {
+            result.emplace_back(pos, id);
+        }
+        std::sort(result.begin(), result.end());
+
+        EXPECT_EQ(expected, result)
+            << "multi pattern matcher finds all occurrences of all patterns";
+
+        string_multi_matcher_free(m);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(StringMultiMatchEngines, StringMultiMatcherTest, Values(
+    STRING_MULTI_MATCH_AHO_CORASICK,
+    STRING_MULTI_MATCH_RABIN_KARP));
+
+class StringIndexTest : public TestWithParam<string_index_type>
+{};
+
+TEST_P(StringIndexTest, CanCountAndLocatePatterns)
+{
+    auto type = GetParam();
+
+    for (auto const &test_input : test_inputs) {
+        auto idx = string_index_create(type, std::get<0>(test_input));
+        ASSERT_NE(idx, nullptr)
+            << "string index can be created";
+
+        auto const &expected = std::get<2>(test_input);
+
+        EXPECT_EQ(expected.size(),
+                  string_index_count(idx, std::get<1>(test_input)))
+            << "string index counts all matches";
+
+        std::size_t *matches;
+        std::size_t n_matches = string_index_locate(
+            idx, std::get<1>(test_input), &matches);
+
+        ASSERT_EQ(expected.size(), n_matches)
+            << "string index locates all matches";
+
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), matches))
+            << "string index returns ordered matches";
+
+        std::free(matches);
+        string_index_free(idx);
+    }
+
+    auto idx = string_index_create(type, "");
+    ASSERT_NE(idx, nullptr)
+        << "string index can be created for empty text";
+
+    EXPECT_EQ(0u, string_index_count(idx, "a"))
+        << "empty text contains no matches";
+
+    string_index_free(idx);
+}
+
+TEST_P(StringIndexTest, CanCountAndLocateRandomPatterns)
+{
+    auto type = GetParam();
+
+    std::mt19937 gen(42u);
+
+    /* small alphabets and all bytes including NUL, long enough to span
+       several rank superblocks */
+    for (int sigma : {1, 2, 4, 256}) {
+        std::uniform_int_distribution<int> dist(0, sigma - 1);
+
+        std::string text;
+        for (std::size_t i = 0u; i < 200000u; ++i)
+            text.push_back(static_cast<char>(sigma == 256 ? dist(gen)
+                                                          : 'a' + dist(gen)));
+
+        auto idx = string_index_create_n(type, text.data(), text.size());
+        ASSERT_NE(idx, nullptr)
+            << "string index can be created";
+
+        std::uniform_int_distribution<std::size_t> pos_dist(0u, text.size());
+
+        for (int i = 0; i < 50; ++i) {
+            std::size_t pos = pos_dist(gen);
+            std::string comp = text.substr(pos, 1u + i % 12);
+
+            /* some patterns that are not taken from the text */
+            if (i % 5 == 0)
+                comp.back() = 'z';
+
+            std::vector<std::size_t> expected;
+            for (auto p = text.find(comp);
+                 p != std::string::npos;
+                 p = text.find(comp, p + 1u)) {
+                expected.push_back(p);
+            }
+
+            EXPECT_EQ(expected.size(),
+                      string_index_count_n(idx, comp.data(), comp.size()))
+                << "string index counts all matches";
+
+            /* locating the occurrences of short patterns in unary texts
+               takes too long */
+            if (expected.size() > 10000u)
+                continue;
+
+            std::size_t *matches;
+            std::size_t n_matches = string_index_locate_n(
+                idx, comp.data(), comp.size(), &matches);
+
+            ASSERT_EQ(expected.size(), n_matches)
+                << "string index locates all matches";
+
+            EXPECT_TRUE(std::equal(expected.begin(), expected.end(), matches))
+                << "string index returns ordered matches";
+
+            std::free(matches);
+        }
+
+        string_index_free(idx);
+    }
+}
+
+TEST_P(StringIndexTest, CanSaveAndLoadIndexes)
+{
+    auto type = GetParam();
+
+    std::mt19937 gen(42u);
+    std::uniform_int_distribution<int> dist(0, 3);
+
+    std::string text;
+    for (std::size_t i = 0u; i < 100000u; ++i)
+        text.push_back("acgt"[dist(gen)]);
+
+    auto idx = string_index_create_n(type, text.data(), text.size());
+    ASSERT_NE(idx, nullptr)
+        << "string index can be created";
+
+    char path[] = "/tmp/test_string_index_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    close(fd);
+
+    EXPECT_TRUE(string_index_save(idx, path))
+        << "string index can be saved";
+
+    auto loaded = string_index_load(path);
+    ASSERT_NE(loaded, nullptr)
+        << "string index can be loaded";
+
+    for (char const *comp : {"a", "acgt", "ttttttt", "gattaca", "x"}) {
+        std::size_t *expected;
+        std::size_t n_expected = string_index_locate(idx, comp, &expected);
+
+        std::size_t *matches;
+        std::size_t n_matches = string_index_locate(loaded, comp, &matches);
+
+        ASSERT_EQ(n_expected, n_matches)
+            << "loaded string index finds the same matches";
+
+        EXPECT_TRUE(std::equal(expected, expected + n_expected, matches))
+            << "loaded string index finds the same matches";
+
+        std::free(expected);
+        std::free(matches);
+    }
+
+    string_index_free(loaded);
+
+    /* truncated files are rejected */
+    ASSERT_EQ(0, truncate(path, 1000));
+    EXPECT_EQ(string_index_load(path), nullptr)
+        << "truncated string index can not be loaded";
+
+    std::remove(path);
+
+    EXPECT_EQ(string_index_load(path), nullptr)
+        << "missing string index can not be loaded";
+
+    string_index_free(idx);
+}
+
+INSTANTIATE_TEST_CASE_P(StringIndexTypes, StringIndexTest, Values(
+    STRING_INDEX_SUFFIX_ARRAY,
+    STRING_INDEX_FM));
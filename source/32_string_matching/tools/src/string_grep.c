@@ -0,0 +1,175 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "string_matching.h"
+
+static struct {
+    char const *name;
+    enum string_match_engine engine;
+} const engines[] = {
+    { "auto", STRING_MATCH_AUTO },
+    { "naive", STRING_MATCH_NAIVE },
+    { "rabin-karp", STRING_MATCH_RABIN_KARP },
+    { "dfa", STRING_MATCH_DFA },
+    { "kmp", STRING_MATCH_KMP },
+    { "boyer-moore", STRING_MATCH_BOYER_MOORE },
+    { "two-way", STRING_MATCH_TWO_WAY },
+    { "shift-or", STRING_MATCH_SHIFT_OR },
+    { "bndm", STRING_MATCH_BNDM }
+};
+
+#define N_ENGINES (sizeof(engines) / sizeof(engines[0]))
+
+static void usage(char const *prog)
+{
+    fprintf(stderr, "usage: %s [-c] [-t] [-e ENGINE] PATTERN FILE...\n", prog);
+    fprintf(stderr, "  -c  only print the number of matches per file\n");
+    fprintf(stderr, "  -t  print search time and throughput to stderr\n");
+    fprintf(stderr, "  -e  string matching engine, one of:");
+    for (size_t i = 0; i < N_ENGINES; ++i)
+        fprintf(stderr, " %s", engines[i].name);
+    fprintf(stderr, " (default: %s)\n", engines[0].name);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int grep_file(struct string_matcher *m, char const *path,
+                     int count_only, int timing)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror(path);
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror(path);
+        close(fd);
+        return 0;
+    }
+
+    size_t text_len = st.st_size;
+    char const *text = NULL;
+
+    if (text_len > 0) {
+        text = mmap(NULL, text_len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text == MAP_FAILED) {
+            perror(path);
+            close(fd);
+            return 0;
+        }
+
+        madvise((void *) text, text_len, MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+
+    double start = now();
+
+    size_t count = 0;
+    string_matcher_reset_n(m, text, text_len);
+
+    if (count_only) {
+        count = string_matcher_count(m);
+    } else {
+        size_t matches[1024];
+
+        size_t n;
+        do {
+            n = string_matcher_find_all(m, matches, 1024);
+
+            for (size_t i = 0; i < n; ++i)
+                printf("%s:%zu\n", path, matches[i]);
+
+            count += n;
+        } while (n == 1024);
+    }
+
+    double elapsed = now() - start;
+
+    if (count_only)
+        printf("%s:%zu\n", path, count);
+
+    if (timing) {
+        fprintf(stderr, "%s: %zu bytes in %.6f s (%.3f GB/s)\n",
+                path, text_len, elapsed,
+                elapsed > 0 ? text_len / elapsed * 1e-9 : 0.0);
+    }
+
+    if (text)
+        munmap((void *) text, text_len);
+
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int count_only = 0;
+    int timing = 0;
+    enum string_match_engine engine = engines[0].engine;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "cte:")) != -1) {
+        switch (opt) {
+        case 'c':
+            count_only = 1;
+            break;
+        case 't':
+            timing = 1;
+            break;
+        case 'e': {
+            size_t i = 0;
+            while (i < N_ENGINES && strcmp(optarg, engines[i].name) != 0)
+                ++i;
+
+            if (i == N_ENGINES) {
+                fprintf(stderr, "%s: unknown engine '%s'\n", argv[0], optarg);
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            engine = engines[i].engine;
+            break;
+        }
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind < 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct string_matcher *m = string_matcher_create(engine, argv[optind]);
+    if (!m) {
+        fprintf(stderr, "%s: failed to preprocess pattern\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int ret = EXIT_SUCCESS;
+    for (int i = optind + 1; i < argc; ++i) {
+        if (!grep_file(m, argv[i], count_only, timing))
+            ret = EXIT_FAILURE;
+    }
+
+    string_matcher_free(m);
+
+    return ret;
+}